@@ -6,4 +6,9 @@
 #define     lumpy_api   __declspec(dllexport)
 #endif
 
-#define     lumpy_abi   extern "C" lumpy_api
\ No newline at end of file
+#define     lumpy_abi   extern "C" lumpy_api
+
+// kernel profiling counters, see lumpy/core/trace.h.
+#ifndef LUMPY_PROFILE
+#define     LUMPY_PROFILE   0
+#endif
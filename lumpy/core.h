@@ -5,6 +5,8 @@
 #include <lumpy/core/type.h>
 #include <lumpy/core/array.h>
 #include <lumpy/core/memory.h>
+#include <lumpy/core/parallel.h>
+#include <lumpy/core/trace.h>
 
 namespace lumpy
 {
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <lumpy/config.h>
+#include <lumpy/core/type.h>
+#include <lumpy/core/trace.h>
+
+namespace lumpy
+{
+
+namespace core
+{
+
+inline size_t thread_count() noexcept
+{
+    static const auto count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+// number of tasks parallel_for splits `count` items into.
+constexpr size_t task_count(size_t count, size_t grain, size_t threads) noexcept
+{
+    return count <= grain ? 1 : ((count + grain - 1) / grain < threads ? (count + grain - 1) / grain : threads);
+}
+
+namespace detail
+{
+// one parallel_for call: its tasks are handed out one at a time, to the pool's workers and to
+// the calling thread, which also waits for the last one to finish.
+struct parallel_job
+{
+    void              (*call)(void* context, size_t task);
+    void*               context;
+    size_t              tasks;
+    size_t              next  = 1;      // task 0 is the caller's
+    size_t              done  = 0;
+    std::exception_ptr  error;          // the first exception thrown by a task
+    std::condition_variable finished;
+};
+
+// true on pool workers and on a caller while it runs tasks: a parallel_for from inside a task
+// runs inline, so nested calls neither wait on a busy pool nor oversubscribe the cores.
+inline bool& in_parallel() noexcept
+{
+    thread_local bool value = false;
+    return value;
+}
+
+// thread_count() - 1 workers, started on first use and joined at exit. their thread_locals
+// (the lane buffers of the sort kernels, the trace buffers) live as long as the process.
+class thread_pool
+{
+public:
+    static thread_pool& instance()
+    {
+        static thread_pool pool(thread_count() - 1);
+        return pool;
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _ready.notify_all();
+        for (auto& worker : _workers) worker.join();
+    }
+
+    // run every task of `job` on the workers and the calling thread; returns once all are done
+    // and rethrows the first exception any of them threw.
+    void run(parallel_job& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back(&job);
+        }
+        _ready.notify_all();
+
+        in_parallel() = true;
+        execute(job, 0);
+
+        // help with what the workers have not picked up yet, then wait for the rest.
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (job.next < job.tasks) {
+            const auto task = claim(job);
+            lock.unlock();
+            execute(job, task);
+            lock.lock();
+        }
+        job.finished.wait(lock, [&] { return job.done == job.tasks; });
+        in_parallel() = false;
+
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+private:
+    std::mutex                  _mutex;
+    std::condition_variable     _ready;
+    std::deque<parallel_job*>   _jobs;
+    std::vector<std::thread>    _workers;
+    bool                        _stop = false;
+
+    explicit thread_pool(size_t count)
+    {
+        _workers.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            _workers.emplace_back([this] { work(); });
+        }
+    }
+
+    // next task of `job`; the job leaves the queue with its last task. _mutex is held.
+    size_t claim(parallel_job& job)
+    {
+        const auto task = job.next++;
+        if (job.next == job.tasks) {
+            _jobs.erase(std::find(_jobs.begin(), _jobs.end(), &job));
+        }
+        return task;
+    }
+
+    void execute(parallel_job& job, size_t task)
+    {
+        std::exception_ptr error;
+        try {
+            job.call(job.context, task);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        // notified under the lock: the caller cannot see done == tasks and return (destroying
+        // `job`) before this thread is through with it.
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (error && !job.error) job.error = error;
+        if (++job.done == job.tasks) job.finished.notify_all();
+    }
+
+    void work()
+    {
+        in_parallel() = true;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+            _ready.wait(lock, [&] { return _stop || !_jobs.empty(); });
+            if (_stop) return;
+
+            auto& job = *_jobs.front();
+            const auto task = claim(job);
+            lock.unlock();
+            execute(job, task);
+            lock.lock();
+        }
+    }
+};
+}
+
+// run func(task, first, last) over [0, count) in contiguous chunks of at least `grain` items,
+// on a persistent pool of threads. the calling thread takes the first chunk; below `grain`
+// items, or when called from inside another parallel_for, everything runs inline. an
+// exception thrown by func is rethrown here once every chunk has finished.
+template<class F>
+void parallel_for(size_t count, size_t grain, F&& func)
+{
+    const auto tasks = task_count(count, grain, thread_count());
+    if (tasks <= 1 || detail::in_parallel()) {
+        if (count != 0) func(size_t(0), size_t(0), count);
+        return;
+    }
+
+    struct chunks
+    {
+        F&      func;
+        size_t  count;
+        size_t  size;
+#if LUMPY_PROFILE
+        trace::scope* scope = trace::scope::active();  // allocations in the tasks count toward the caller's kernel
+#endif
+    } state{ func, count, (count + tasks - 1) / tasks };
+
+    detail::parallel_job job;
+    job.context = &state;
+    job.tasks   = (count + state.size - 1) / state.size;
+    job.call    = [](void* context, size_t task) {
+        auto& state = *static_cast<chunks*>(context);
+#if LUMPY_PROFILE
+        trace::scope::adopt adopt(state.scope);
+#endif
+        auto first  = task * state.size;
+        auto last   = first + state.size < state.count ? first + state.size : state.count;
+        state.func(task, first, last);
+    };
+
+    if (job.tasks <= 1) {
+        func(size_t(0), size_t(0), count);
+        return;
+    }
+    detail::thread_pool::instance().run(job);
+}
+
+}
+
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <lumpy/config.h>
+#include <lumpy/core/type.h>
+
+#if LUMPY_PROFILE
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#endif
+
+namespace lumpy
+{
+
+namespace core
+{
+
+namespace trace
+{
+
+// how a kernel ran; flags combine (a vectorized loop split over threads is simd|parallel).
+enum class path : unsigned char
+{
+    scalar      = 0,
+    simd        = 1,
+    parallel    = 2,
+};
+
+constexpr path operator|(path a, path b) { return path(unsigned(a) | unsigned(b)); }
+
+// `how`, plus parallel when the work was split into more than one task.
+constexpr path split(size_t tasks, path how = path::scalar) { return tasks > 1 ? how | path::parallel : how; }
+
+inline const char* to_string(path value)
+{
+    static const char* const names[] = { "scalar", "simd", "parallel", "simd+parallel" };
+    return unsigned(value) < 4 ? names[unsigned(value)] : "unknown";
+}
+
+#if LUMPY_PROFILE
+
+// one kernel call, as recorded by lumpy_trace().
+struct event
+{
+    const char* name;
+    path        how;
+    ullong      begin;          // ns, steady clock
+    ullong      end;
+    size_t      elements;
+    size_t      bytes;          // bytes read + written
+    size_t      allocs;         // temporary allocations made inside the call
+    size_t      alloc_bytes;
+};
+
+namespace detail
+{
+struct buffer
+{
+    size_t              tid;
+    std::vector<event>  events;
+};
+
+struct registry
+{
+    std::mutex                              mutex;
+    std::vector<std::shared_ptr<buffer>>    buffers;
+    std::atomic<bool>                       enabled{ false };
+};
+
+inline registry& get_registry()
+{
+    static registry instance;
+    return instance;
+}
+
+// every thread appends to its own buffer, without locking; the registry keeps the
+// buffers alive after their thread exits.
+inline buffer& local_buffer()
+{
+    thread_local auto local = [] {
+        auto& reg = get_registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto value = std::make_shared<buffer>();
+        value->tid = reg.buffers.size();
+        reg.buffers.push_back(value);
+        return value;
+    }();
+    return *local;
+}
+
+inline ullong now()
+{
+    using namespace std::chrono;
+    return ullong(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+// ns as fixed point microseconds, which is what the trace format wants.
+inline void write_us(std::ostream& os, ullong ns)
+{
+    auto frac = ns % 1000;
+    os << ns / 1000 << '.' << char('0' + frac / 100) << char('0' + frac / 10 % 10) << char('0' + frac % 10);
+}
+}
+
+inline void enable(bool value = true)   { detail::get_registry().enabled = value; }
+inline bool enabled()                   { return detail::get_registry().enabled; }
+
+// drop all recorded events; no kernel may be running.
+inline void clear()
+{
+    auto& reg = detail::get_registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& buffer : reg.buffers) buffer->events.clear();
+}
+
+class scope
+{
+public:
+    scope(const char* name, path how, size_t elements, size_t bytes)
+        : _event{ name, how, 0, 0, elements, bytes, 0, 0 }
+        , _active(enabled())
+        , _outer(current())
+    {
+        if (!_active) return;
+        current() = this;
+        _event.begin = detail::now();
+    }
+
+    ~scope()
+    {
+        if (!_active) return;
+        _event.end         = detail::now();
+        _event.allocs      = _allocs.load(std::memory_order_relaxed);
+        _event.alloc_bytes = _alloc_bytes.load(std::memory_order_relaxed);
+        current() = _outer;
+        detail::local_buffer().events.push_back(_event);
+    }
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+    // counted on the active scope of this thread; parallel_for tasks share their caller's, so
+    // several threads may add to one scope at once.
+    static void record_alloc(size_t bytes)
+    {
+        auto active = current();
+        if (active == nullptr) return;
+        active->_allocs.fetch_add(1, std::memory_order_relaxed);
+        active->_alloc_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static scope* active() noexcept { return current(); }
+
+    // makes `outer` the active scope of this thread while it lives. parallel_for runs each
+    // task under the scope of the thread that started it.
+    class adopt
+    {
+    public:
+        explicit adopt(scope* outer) : _saved(current()) { current() = outer; }
+        ~adopt() { current() = _saved; }
+
+        adopt(const adopt&) = delete;
+        adopt& operator=(const adopt&) = delete;
+
+    private:
+        scope*  _saved;
+    };
+
+private:
+    event               _event;
+    bool                _active;
+    scope*              _outer;
+    std::atomic<size_t> _allocs{ 0 };
+    std::atomic<size_t> _alloc_bytes{ 0 };
+
+    static scope*& current()
+    {
+        thread_local scope* value = nullptr;
+        return value;
+    }
+};
+
+// all events as chrome://tracing / perfetto json; no kernel may be running.
+inline void write_trace(std::ostream& os)
+{
+    auto& reg = detail::get_registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    os << "{\"traceEvents\":[";
+    auto first = true;
+    for (auto& buffer : reg.buffers) {
+        for (auto& e : buffer->events) {
+            os << (first ? "\n" : ",\n");
+            os << "{\"name\":\"" << e.name << "\",\"cat\":\"lumpy\",\"ph\":\"X\""
+               << ",\"ts\":";
+            detail::write_us(os, e.begin);
+            os << ",\"dur\":";
+            detail::write_us(os, e.end - e.begin);
+            os << ",\"pid\":0,\"tid\":" << buffer->tid
+               << ",\"args\":{\"path\":\"" << to_string(e.how) << "\""
+               << ",\"elements\":" << e.elements
+               << ",\"bytes\":" << e.bytes
+               << ",\"allocs\":" << e.allocs
+               << ",\"alloc_bytes\":" << e.alloc_bytes << "}}";
+            first = false;
+        }
+    }
+    os << "\n]}\n";
+}
+
+// per kernel and path: calls, total time and volume, as json; no kernel may be running.
+inline void write_summary(std::ostream& os)
+{
+    struct total { size_t calls = 0; ullong ns = 0; size_t elements = 0, bytes = 0, allocs = 0; };
+    std::map<std::pair<string, path>, total> totals;
+
+    auto& reg = detail::get_registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& buffer : reg.buffers) {
+            for (auto& e : buffer->events) {
+                auto& t = totals[{ e.name, e.how }];
+                t.calls    += 1;
+                t.ns       += e.end - e.begin;
+                t.elements += e.elements;
+                t.bytes    += e.bytes;
+                t.allocs   += e.allocs;
+            }
+        }
+    }
+
+    os << "[";
+    auto first = true;
+    for (auto& item : totals) {
+        auto& t = item.second;
+        os << (first ? "\n" : ",\n");
+        os << "{\"name\":\"" << item.first.first << "\",\"path\":\"" << to_string(item.first.second) << "\""
+           << ",\"calls\":" << t.calls << ",\"ns\":" << t.ns << ",\"elements\":" << t.elements
+           << ",\"bytes\":" << t.bytes << ",\"allocs\":" << t.allocs << "}";
+        first = false;
+    }
+    os << "\n]\n";
+}
+
+#endif
+
+}
+
+}
+
+}
+
+// instrumentation points used by the kernels. with LUMPY_PROFILE off (the default) they
+// expand to nothing and their arguments are never evaluated.
+#if LUMPY_PROFILE
+#define lumpy_trace(name, how, elements, bytes)     lumpy::core::trace::scope _lumpy_trace_scope(name, how, elements, bytes)
+#define lumpy_trace_alloc(bytes)                    lumpy::core::trace::scope::record_alloc(bytes)
+#else
+#define lumpy_trace(name, how, elements, bytes)     ((void)0)
+#define lumpy_trace_alloc(bytes)                    ((void)0)
+#endif
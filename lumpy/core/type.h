@@ -202,6 +202,66 @@ template<               class ...Types> constexpr bool is_uint      = std::conju
 template<               class ...Types> constexpr bool is_ptr       = std::conjunction<std::is_pointer<Types>...>::value;
 #pragma endregion
 
+#pragma region types
+template<class ...Ts>
+struct types_t
+{
+    static constexpr size_t size = sizeof...(Ts);
+};
+
+namespace detail
+{
+template<class T, class ...Ts>
+struct _Index_Of;
+
+template<class T>
+struct _Index_Of<T>
+{
+    static constexpr size_t value = 0;
+};
+
+template<class T, class T0, class ...Ts>
+struct _Index_Of<T, T0, Ts...>
+{
+    static constexpr size_t value = is_same<T, T0> ? 0 : 1 + _Index_Of<T, Ts...>::value;
+};
+
+template<size_t I, class ...Ts>
+struct _Type_At;
+
+template<class T0, class ...Ts>
+struct _Type_At<0, T0, Ts...>
+{
+    using type = T0;
+};
+
+template<size_t I, class T0, class ...Ts>
+struct _Type_At<I, T0, Ts...> : _Type_At<I - 1, Ts...>
+{};
+
+template<class T, class Types>
+struct _Index_In;
+
+template<class T, class ...Ts>
+struct _Index_In<T, types_t<Ts...>> : _Index_Of<T, Ts...>
+{};
+
+template<size_t I, class Types>
+struct _Type_In;
+
+template<size_t I, class ...Ts>
+struct _Type_In<I, types_t<Ts...>> : _Type_At<I, Ts...>
+{};
+}
+
+// position of T in a types_t<...>, or its size if T is not there.
+template<class T, class Types>
+constexpr size_t index_of = detail::_Index_In<T, Types>::value;
+
+template<size_t I, class Types>
+using type_at = typename detail::_Type_In<I, Types>::type;
+#pragma endregion
+
 #pragma region remove/add
 template<class Type>
 using remove_cv = std::remove_cv_t<Type>;
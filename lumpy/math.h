@@ -3,6 +3,16 @@
 #include <lumpy/math/view.h>
 #include <lumpy/math/slice.h>
 #include <lumpy/math/array.h>
+#include <lumpy/math/eval.h>
+#include <lumpy/math/dynamic.h>
+#include <lumpy/math/sort.h>
+#include <lumpy/math/random.h>
+#include <lumpy/math/histogram.h>
+#include <lumpy/math/rolling.h>
+#include <lumpy/math/linalg.h>
+#include <lumpy/math/batch.h>
+#include <lumpy/math/concat.h>
+#include <lumpy/math/shared.h>
 
 namespace lumpy
 {
@@ -22,9 +22,11 @@ public:
     {}
 
     explicit ndarray(const size_t(&shape)[N])
-        : base(array_view<T>(new T[sum_array(shape)], sum_array(shape)), shape)
-        , _sdata(base::_data._elements)
-    {}
+        : base(array_view<T>(new T[product_array(shape)], product_array(shape)), shape)
+        , _sdata(base::_data._elements, std::default_delete<T[]>())
+    {
+        lumpy_trace_alloc(product_array(shape) * sizeof(T));
+    }
 
     template<size_t ..._Ns, class = static_if<sizeof...(_Ns) == N && if_all((_Ns <= 2)...) > >
     constexpr ndarray< T, select_indexs<2, _Ns...>::size> slice(const size_t(&...sections)[_Ns]) const
@@ -32,9 +34,17 @@ public:
         return{ base::slice(sections...),  _sdata};
     }
 
+    constexpr auto& sdata() const { return _sdata; }
+
 protected:
     std::shared_ptr<T>  _sdata;
 };
 
+template<class T, size_t N>
+struct _IsExpr<ndarray<T, N>> : true_type{};
+
+template<class T, size_t N>
+struct _SameExpr<ndarray<T, N>> : _SameExpr<ndslice<array_view<T>, N>>{};
+
 }
 }
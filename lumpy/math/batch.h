@@ -0,0 +1,405 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+// many small matrices at once. axis 0 of the operands is the batch, so an ndarray<T, 3> of
+// shape { batch, n, n } already stores element (i, j) of consecutive matrices side by side.
+// blocks of L matrices are gathered into that interleaved form, element (i, j) of matrix l
+// at block[(i + j*n)*L + l], and every kernel loops over l innermost: simd lanes run across
+// matrices, never within one, and pivoting is done with selects instead of branches.
+//
+// the common sizes 2, 3, 4 and 8 get their own fully unrolled kernel, with the sizes passed
+// as std::integral_constant; every other n runs the same code with runtime sizes.
+namespace detail
+{
+constexpr size_t batch_grain = 1 << 14;    // matrix elements per task
+
+template<size_t N>
+using size_constant = std::integral_constant<size_t, N>;
+
+// matrices per block: small ones in wide blocks, so loops over l stay long enough.
+template<size_t N>
+constexpr size_t batch_lanes = N <= 4 ? 64 : (N <= 8 ? 32 : 16);
+constexpr size_t any_lanes   = 16;     // for the sizes without their own kernel
+
+// lanes batch_dispatch(n, ...) runs with.
+constexpr size_t lanes_of(size_t n)
+{
+    return n == 2 ? batch_lanes<2> : n == 3 ? batch_lanes<3> : n == 4 ? batch_lanes<4> : n == 8 ? batch_lanes<8> : any_lanes;
+}
+
+// element e (i + j*rows) of matrices first..first+count of `s` into block[e*L + l]; lanes past
+// `count` repeat the last matrix, so they compute something finite and are then dropped.
+template<size_t L, class T, size_t N>
+void gather(const ndslice<array_view<T>, N>& s, size_t first, size_t count, T* block)
+{
+    const auto stride   = s.stride()[0];
+    const auto elements = s.size() / s.shape()[0];
+
+    for (size_t e = 0; e < elements; ++e) {
+        auto in  = &s.data()[lane_offset(s, 0, e) + first * stride];
+        auto out = block + e * L;
+        for (size_t l = 0; l < count; ++l) out[l] = in[l * stride];
+        for (auto l = count; l < L; ++l)    out[l] = out[count - 1];
+    }
+}
+
+template<size_t L, class T, size_t N>
+void scatter(const ndslice<array_view<T>, N>& s, size_t first, size_t count, const T* block)
+{
+    const auto stride   = s.stride()[0];
+    const auto elements = s.size() / s.shape()[0];
+
+    for (size_t e = 0; e < elements; ++e) {
+        auto out = &s.data()[lane_offset(s, 0, e) + first * stride];
+        auto in  = block + e * L;
+        for (size_t l = 0; l < count; ++l) out[l * stride] = in[l];
+    }
+}
+
+// blocks of `lanes` matrices per task, with `scratch` elements of scratch space per matrix.
+inline size_t block_grain(size_t lanes, size_t scratch)
+{
+    return std::max(size_t(1), batch_grain / (lanes * scratch));
+}
+
+// tasks for_each_block splits `batch` matrices into, for the trace.
+inline size_t block_tasks(size_t batch, size_t lanes, size_t scratch)
+{
+    return task_count((batch + lanes - 1) / lanes, block_grain(lanes, scratch), thread_count());
+}
+
+// run func(first, count, scratch) over blocks of L matrices, with `scratch` elements of
+// scratch space per task.
+template<size_t L, class T, class F>
+void for_each_block(size_t batch, size_t scratch, F&& func)
+{
+    const auto blocks = (batch + L - 1) / L;
+    const auto grain  = block_grain(L, scratch);
+
+    parallel_for(blocks, grain, [&](size_t, size_t first, size_t last) {
+        std::vector<T> buffer(scratch * L);
+        for (auto block = first; block < last; ++block) {
+            func(block * L, std::min(L, batch - block * L), buffer.data());
+        }
+    });
+}
+
+// c = a * b for every lane; a is m x k, b is k x n.
+template<size_t L, class T, class Size>
+void matmul_lanes(Size m, Size k, Size n, const T* a, const T* b, T* c)
+{
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < m; ++i) {
+            T sum[L] = {};
+            for (size_t p = 0; p < k; ++p) {
+                auto x = a + (i + p * m) * L;
+                auto y = b + (p + j * k) * L;
+                for (size_t l = 0; l < L; ++l) sum[l] += x[l] * y[l];
+            }
+
+            auto z = c + (i + j * m) * L;
+            for (size_t l = 0; l < L; ++l) z[l] = sum[l];
+        }
+    }
+}
+
+// gaussian elimination with partial pivoting for every lane: b (n x nrhs) becomes a^-1 * b,
+// det (when given) the determinant of a. a is overwritten. returns whether any of the first
+// `count` lanes is singular; its b is then not finite, and its det 0.
+template<size_t L, class T, class Size>
+bool gauss_lanes(Size n, size_t nrhs, T* a, T* b, T* det, size_t count)
+{
+    auto at = [&](T* m, size_t i, size_t j) { return m + (i + j * n) * L; };
+
+    T scale[L];
+    bool singular[L];
+    for (size_t l = 0; l < L; ++l) {
+        scale[l]    = T(1);
+        singular[l] = false;
+    }
+
+    for (size_t c = 0; c < n; ++c) {
+        // pivot row of each lane, kept as T so the selects stay in one vector width.
+        T pivot[L], best[L];
+        for (size_t l = 0; l < L; ++l) {
+            pivot[l] = T(c);
+            best[l]  = std::abs(at(a, c, c)[l]);
+        }
+        for (auto r = c + 1; r < n; ++r) {
+            auto x = at(a, r, c);
+            for (size_t l = 0; l < L; ++l) {
+                auto value = std::abs(x[l]);
+                auto take  = value > best[l];
+                best[l]  = take ? value : best[l];
+                pivot[l] = take ? T(r) : pivot[l];
+            }
+        }
+        for (size_t l = 0; l < L; ++l) singular[l] |= best[l] == T(0);
+
+        // swap row c with the pivot row, lane by lane.
+        auto swap_rows = [&](T* m, size_t r, size_t j) {
+            auto x = at(m, c, j), y = at(m, r, j);
+            for (size_t l = 0; l < L; ++l) {
+                auto take = pivot[l] == T(r);
+                auto u = x[l], v = y[l];
+                x[l] = take ? v : u;
+                y[l] = take ? u : v;
+            }
+        };
+        for (auto r = c + 1; r < n; ++r) {
+            for (auto j = c; j < n; ++j)        swap_rows(a, r, j);
+            for (size_t j = 0; j < nrhs; ++j)   swap_rows(b, r, j);
+        }
+
+        // the pivot is replaced by its reciprocal, which is all back substitution needs.
+        T inverse[L];
+        auto d = at(a, c, c);
+        for (size_t l = 0; l < L; ++l) {
+            scale[l]  *= pivot[l] == T(c) ? d[l] : -d[l];
+            inverse[l] = T(1) / d[l];
+            d[l]       = inverse[l];
+        }
+
+        for (auto r = c + 1; r < n; ++r) {
+            T factor[L];
+            auto x = at(a, r, c);
+            for (size_t l = 0; l < L; ++l) factor[l] = x[l] * inverse[l];
+
+            for (auto j = c + 1; j < n; ++j) {
+                auto y = at(a, r, j), z = at(a, c, j);
+                for (size_t l = 0; l < L; ++l) y[l] -= factor[l] * z[l];
+            }
+            for (size_t j = 0; j < nrhs; ++j) {
+                auto y = at(b, r, j), z = at(b, c, j);
+                for (size_t l = 0; l < L; ++l) y[l] -= factor[l] * z[l];
+            }
+        }
+    }
+
+    if (det != nullptr) {
+        for (size_t l = 0; l < L; ++l) det[l] = singular[l] ? T(0) : scale[l];
+    }
+
+    // back substitution, one column of b at a time.
+    for (size_t j = 0; j < nrhs; ++j) {
+        for (auto c = size_t(n); c-- > 0; ) {
+            auto x = at(b, c, j), d = at(a, c, c);
+            for (size_t l = 0; l < L; ++l) x[l] *= d[l];
+
+            for (size_t r = 0; r < c; ++r) {
+                auto y = at(b, r, j), z = at(a, r, c);
+                for (size_t l = 0; l < L; ++l) y[l] -= z[l] * x[l];
+            }
+        }
+    }
+
+    auto any = false;
+    for (size_t l = 0; l < count; ++l) any |= singular[l];
+    return any;
+}
+
+// kernel.run<n>() for the unrolled sizes, kernel.run_any(n) for the others.
+template<class K>
+void batch_dispatch(size_t n, const K& kernel)
+{
+    switch (n) {
+    case 2:  kernel.template run<2>(); break;
+    case 3:  kernel.template run<3>(); break;
+    case 4:  kernel.template run<4>(); break;
+    case 8:  kernel.template run<8>(); break;
+    default: kernel.run_any(n);        break;
+    }
+}
+
+template<class T>
+struct batch_matmul_kernel
+{
+    const ndslice<array_view<T>, 3>&    a;
+    const ndslice<array_view<T>, 3>&    b;
+    const ndslice<array_view<T>, 3>&    c;
+
+    template<size_t N> void run()   const { apply<batch_lanes<N>>(size_constant<N>{}, size_constant<N>{}, size_constant<N>{}); }
+    void run_any(size_t)            const { apply<any_lanes>(a.shape()[1], a.shape()[2], b.shape()[2]); }
+
+    template<size_t L, class Size>
+    void apply(Size m, Size k, Size n) const
+    {
+        for_each_block<L, T>(a.shape()[0], m * k + k * n + m * n, [&](size_t first, size_t count, T* scratch) {
+            auto x = scratch, y = x + m * k * L, z = y + k * n * L;
+            gather<L>(a, first, count, x);
+            gather<L>(b, first, count, y);
+            matmul_lanes<L>(m, k, n, x, y, z);
+            scatter<L>(c, first, count, z);
+        });
+    }
+};
+
+// solves, inverses (b is the identity) and determinants (no b) through gauss_lanes.
+template<class T, size_t R>
+struct batch_gauss_kernel
+{
+    const ndslice<array_view<T>, 3>&    a;
+    const ndslice<array_view<T>, R>*    b;          // right hand sides, or null
+    const ndslice<array_view<T>, R>*    x;          // solutions, or null
+    const ndslice<array_view<T>, 1>*    det;        // determinants, or null
+    bool                                identity;
+    std::atomic<bool>&                  singular;   // set when any matrix is
+
+    template<size_t N> void run()   const { apply<batch_lanes<N>>(size_constant<N>{}); }
+    void run_any(size_t n)          const { apply<any_lanes>(n); }
+
+    template<size_t L, class Size>
+    void apply(Size n) const
+    {
+        const auto nrhs = x == nullptr ? 0 : x->size() / (x->shape()[0] * n);
+
+        for_each_block<L, T>(a.shape()[0], n * n + n * nrhs + 1, [&](size_t first, size_t count, T* scratch) {
+            auto m = scratch, y = m + n * n * L, d = y + n * nrhs * L;
+            gather<L>(a, first, count, m);
+
+            if (identity) {
+                std::fill(y, y + n * n * L, T(0));
+                for (size_t i = 0; i < n; ++i) std::fill(y + (i + i * n) * L, y + (i + i * n + 1) * L, T(1));
+            }
+            else if (b != nullptr) {
+                gather<L>(*b, first, count, y);
+            }
+
+            if (gauss_lanes<L>(n, nrhs, m, y, det == nullptr ? nullptr : d, count)) {
+                singular.store(true, std::memory_order_relaxed);
+            }
+
+            if (x != nullptr)   scatter<L>(*x, first, count, y);
+            if (det != nullptr) scatter<L>(*det, first, count, d);
+        });
+    }
+};
+
+template<class T>
+void check_batch(const ndslice<array_view<T>, 3>& a)
+{
+    if (a.shape()[1] != a.shape()[2]) {
+        throw std::invalid_argument("lumpy: batched matrices must be square");
+    }
+}
+
+inline void check_regular(const std::atomic<bool>& singular)
+{
+    if (singular) {
+        throw std::domain_error("lumpy: matrix is singular");
+    }
+}
+}
+
+#pragma region batch
+// c[i] = a[i] * b[i] for every matrix of the batch.
+template<class T>
+ndarray<T, 3> batch_matmul(const ndslice<array_view<T>, 3>& a, const ndslice<array_view<T>, 3>& b)
+{
+    const auto batch = a.shape()[0], m = a.shape()[1], k = a.shape()[2], n = b.shape()[2];
+    if (b.shape()[0] != batch || b.shape()[1] != k) {
+        throw std::invalid_argument("lumpy: batch_matmul() operands do not match");
+    }
+
+    ndarray<T, 3> c({ batch, m, n });
+    if (c.size() == 0) return c;
+    if (k == 0) {
+        std::fill(&c.data()[0], &c.data()[0] + c.size(), T(0));
+        return c;
+    }
+
+    lumpy_trace("batch.matmul", trace::split(detail::block_tasks(batch, m == k && k == n ? detail::lanes_of(n) : detail::any_lanes, m * k + k * n + m * n), trace::path::simd), batch * m * k * n, batch * (m * k + k * n + m * n) * sizeof(T));
+
+    detail::batch_matmul_kernel<T> kernel{ a, b, c };
+    if (m == k && k == n) {
+        detail::batch_dispatch(n, kernel);
+    }
+    else {
+        kernel.run_any(0);
+    }
+    return c;
+}
+
+template<class T>
+ndarray<T, 3> batch_inv(const ndslice<array_view<T>, 3>& a)
+{
+    detail::check_batch(a);
+    const auto batch = a.shape()[0], n = a.shape()[1];
+
+    ndarray<T, 3> x({ batch, n, n });
+    if (x.size() == 0) return x;
+
+    lumpy_trace("batch.inv", trace::split(detail::block_tasks(batch, detail::lanes_of(n), 2 * n * n + 1), trace::path::simd), batch * n * n * n, 2 * batch * n * n * sizeof(T));
+
+    std::atomic<bool> singular{ false };
+    detail::batch_dispatch(n, detail::batch_gauss_kernel<T, 3>{ a, nullptr, &x, nullptr, true, singular });
+    detail::check_regular(singular);
+    return x;
+}
+
+template<class T>
+ndarray<T, 1> batch_det(const ndslice<array_view<T>, 3>& a)
+{
+    detail::check_batch(a);
+    const auto batch = a.shape()[0], n = a.shape()[1];
+
+    // the determinant of a 0 x 0 matrix is 1.
+    ndarray<T, 1> det({ batch });
+    if (batch == 0) return det;
+    if (n == 0) {
+        std::fill(&det.data()[0], &det.data()[0] + batch, T(1));
+        return det;
+    }
+
+    lumpy_trace("batch.det", trace::split(detail::block_tasks(batch, detail::lanes_of(n), n * n + 1), trace::path::simd), batch * n * n * n / 3, batch * (n * n + 1) * sizeof(T));
+
+    // a singular matrix has determinant 0, which is no error.
+    std::atomic<bool> singular{ false };
+    detail::batch_dispatch(n, detail::batch_gauss_kernel<T, 1>{ a, nullptr, nullptr, &det, false, singular });
+    return det;
+}
+
+// x[i] with a[i] * x[i] = b[i]; b is { batch, n } or { batch, n, nrhs }.
+template<class T, size_t N, class = static_if<N == 2 || N == 3> >
+ndarray<T, N> batch_solve(const ndslice<array_view<T>, 3>& a, const ndslice<array_view<T>, N>& b)
+{
+    detail::check_batch(a);
+    const auto batch = a.shape()[0], n = a.shape()[1];
+    if (b.shape()[0] != batch || b.shape()[1] != n) {
+        throw std::invalid_argument("lumpy: batch_solve() operands do not match");
+    }
+
+    array<size_t, N> shape;
+    for (size_t i = 0; i < N; ++i) shape[i] = b.shape()[i];
+
+    ndarray<T, N> x(shape._elements);
+    if (x.size() == 0) return x;
+
+    lumpy_trace("batch.solve", trace::split(detail::block_tasks(batch, detail::lanes_of(n), n * n + b.size() / batch + 1), trace::path::simd), batch * n * n * n / 3, (batch * n * n + 2 * b.size()) * sizeof(T));
+
+    std::atomic<bool> singular{ false };
+    detail::batch_dispatch(n, detail::batch_gauss_kernel<T, N>{ a, &b, &x, nullptr, false, singular });
+    detail::check_regular(singular);
+    return x;
+}
+#pragma endregion
+
+}
+
+}
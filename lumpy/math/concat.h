@@ -0,0 +1,521 @@
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/view.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+namespace detail
+{
+constexpr size_t copy_grain = 1 << 16;     // elements per task
+
+// copy the logical elements [first, last) of `in` to the same positions of `out` (same shape).
+template<class T, size_t N>
+void copy_range(const ndslice<array_view<T>, N>& out, const ndslice<array_view<T>, N>& in, size_t first, size_t last)
+{
+    const auto length  = in.shape()[0];
+    const auto stride  = in.stride()[0];
+    const auto ostride = out.stride()[0];
+
+    for_each_run(in, first, last, [&](size_t offset, size_t index, size_t count) {
+        auto src = &in.data()[offset];
+        auto dst = &out.data()[lane_offset(out, 0, index / length) + index % length * ostride];
+        if (stride == 1 && ostride == 1) {
+            std::copy(src, src + count, dst);
+        }
+        else {
+            for (size_t i = 0; i < count; ++i) dst[i * ostride] = src[i * stride];
+        }
+    });
+}
+
+// `count` indexs of `s` along `axis`, from `first`.
+template<class T, size_t N>
+ndslice<array_view<T>, N> section(const ndslice<array_view<T>, N>& s, size_t axis, size_t first, size_t count)
+{
+    auto shape = s.shape();
+    shape[axis] = count;
+
+    const auto offset = first * s.stride()[axis];
+    return{ array_view<T>(&s.data()[0] + offset, s.data().size() - offset), shape._elements, s.stride()._elements };
+}
+
+// `s` with a new axis of length 1 at `axis`.
+template<class T, size_t N>
+ndarray<T, N + 1> expand(const ndarray<T, N>& s, size_t axis)
+{
+    if (axis > N) {
+        throw std::invalid_argument("lumpy: stack axis out of range");
+    }
+
+    size_t shape[N + 1], stride[N + 1];
+    for (size_t i = 0, j = 0; i <= N; ++i) {
+        shape[i]  = i == axis ? 1 : s.shape()[j];
+        stride[i] = i == axis ? 0 : s.stride()[j];
+        if (i != axis) ++j;
+    }
+    return{ ndslice<array_view<T>, N + 1>(s.data(), shape, stride), s.sdata() };
+}
+
+template<class T, size_t N>
+bool is_contiguous(const ndslice<T, N>& s)
+{
+    size_t step = 1;
+    for (size_t i = 0; i < N; ++i) {
+        if (s.shape()[i] != 1 && s.stride()[i] != step) return false;
+        step *= s.shape()[i];
+    }
+    return true;
+}
+
+// a new contiguous array with the elements of `s`.
+template<class T, size_t N>
+ndarray<T, N> copy_of(const ndslice<array_view<T>, N>& s)
+{
+    lumpy_trace("ascontiguous", trace::split(task_count(s.size(), copy_grain, thread_count())), s.size(), 2 * s.size() * sizeof(T));
+
+    ndarray<T, N> result(s.shape()._elements);
+    parallel_for(s.size(), copy_grain, [&](size_t, size_t first, size_t last) {
+        copy_range(result, s, first, last);
+    });
+    return result;
+}
+}
+
+#pragma region ndchunked
+// a lazy concatenation along one axis: the parts, each still in its own buffer, and a table
+// of where each one starts along that axis. append() is O(1), so growing it batch by batch
+// never copies what is already there.
+//
+// it is an expression leaf. assign() and eval() walk its parts and evaluate the expression
+// over each part's range, and copies (ascontiguous) go part by part in parallel bulk runs;
+// element access, which finds the part by binary search, is left for the rest.
+//
+// parts given as slices are kept as views: the arrays they come from must outlive it.
+template<class T, size_t N>
+class ndchunked
+{
+public:
+    explicit ndchunked(size_t axis = 0)
+        : _axis(axis)
+        , _offsets(1, 0)
+        , _starts(1, 0)
+    {
+        if (axis >= N) {
+            throw std::invalid_argument("lumpy: concatenation axis out of range");
+        }
+    }
+
+    template<class P>
+    ndchunked(const std::vector<P>& parts, size_t axis)
+        : ndchunked(axis)
+    {
+        _parts.reserve(parts.size());
+        for (auto& part : parts) append(part);
+    }
+
+    // parts must match in every axis but `axis()`.
+    void append(const ndarray<T, N>& part)
+    {
+        if (!_parts.empty()) {
+            for (size_t i = 0; i < N; ++i) {
+                if (i != _axis && part.shape()[i] != _shape[i]) {
+                    throw std::invalid_argument("lumpy: concatenated arrays differ outside the concatenation axis");
+                }
+            }
+        }
+        else {
+            _shape = part.shape();
+            _shape[_axis] = 0;
+        }
+
+        _parts.push_back(part);
+        _shape[_axis] += part.shape()[_axis];
+        _offsets.push_back(_shape[_axis]);
+        _starts.push_back(_starts.back() + part.size());
+    }
+
+    void append(const ndslice<array_view<T>, N>& part)
+    {
+        append(ndarray<T, N>(part, nullptr));
+    }
+
+public:
+    size_t  axis()      const noexcept { return _axis; }
+    auto&   shape()     const noexcept { return _shape; }
+    auto&   parts()     const noexcept { return _parts; }
+    auto&   offsets()   const noexcept { return _offsets; }     // along axis(), one past the end last
+    size_t  size()      const noexcept { return _starts.back(); }
+
+    template<class..._Is, class = static_if<sizeof...(_Is) == N> >
+    auto operator()(_Is ...indexs) const
+    {
+        array<size_t, N> index = { { size_t(indexs)... } };
+
+        const auto k = size_t(std::upper_bound(_offsets.begin(), _offsets.end(), index[_axis]) - _offsets.begin()) - 1;
+        index[_axis] -= _offsets[k];
+
+        const auto& part = _parts[k];
+        size_t offset = 0;
+        for (size_t i = 0; i < N; ++i) offset += index[i] * part.stride()[i];
+        return part.data()[offset];
+    }
+
+    // copy into `out` (of shape()), split over threads by elements, not by parts, so
+    // thousands of small parts and a few huge ones spread the same way.
+    void copy_to(const ndslice<array_view<T>, N>& out) const
+    {
+        parallel_for(size(), detail::copy_grain, [&](size_t, size_t first, size_t last) {
+            auto k = size_t(std::upper_bound(_starts.begin(), _starts.end(), first) - _starts.begin()) - 1;
+            for (; k < _parts.size() && _starts[k] < last; ++k) {
+                const auto target = detail::section(out, _axis, _offsets[k], _parts[k].shape()[_axis]);
+                detail::copy_range(target, _parts[k], std::max(first, _starts[k]) - _starts[k], std::min(last, _starts[k + 1]) - _starts[k]);
+            }
+        });
+    }
+
+private:
+    size_t                          _axis;
+    array<size_t, N>                _shape = {};
+    std::vector<ndarray<T, N>>      _parts;
+    std::vector<size_t>             _offsets;   // of each part along axis()
+    std::vector<size_t>             _starts;    // of each part in elements
+};
+
+template<class T, size_t N>
+struct _IsExpr<ndchunked<T, N>> : true_type{};
+
+// _HasChunked<E>: whether the expression E reads an ndchunked.
+template<class E>
+struct _HasChunked: false_type{};
+
+template<class T, size_t N>
+struct _HasChunked<ndchunked<T, N>>: true_type{};
+
+template<class F, class ...Ts>
+struct _HasChunked<ndview<F, Ts...>>
+{
+    static constexpr bool value = !if_all(true, !_HasChunked<Ts>::value...);
+};
+
+template<class E>
+constexpr bool has_chunked = _HasChunked<E>::value;
+
+// an operand seen from [first, first + count) along `axis`: index i there is first + i here.
+// used for leaves _Part knows nothing about.
+template<class E>
+struct ndshift
+{
+    E       e;
+    size_t  axis;
+    size_t  first;
+
+    template<class..._Is>
+    auto operator()(_Is ...is) const
+    {
+        return at(array<size_t, sizeof...(_Is)>{ { size_t(is)... } }, to_indexs<sizeof...(_Is)>{});
+    }
+
+private:
+    template<size_t M, size_t ...Is>
+    auto at(array<size_t, M> index, indexs_t<Is...>) const
+    {
+        index[axis] += first;
+        return e(index[Is]...);
+    }
+};
+
+// _Part<E>::run(e, axis, first, count): the expression E restricted to [first, first + count)
+// along `axis`, where no ndchunked of it changes part. arrays and parts become slices.
+template<class E>
+struct _Part
+{
+    using type = ndshift<E>;
+    static type run(const E& e, size_t axis, size_t first, size_t) { return{ e, axis, first }; }
+};
+
+template<class T>
+struct _Part<ndscalar<T>>
+{
+    using type = ndscalar<T>;
+    static type run(const type& e, size_t, size_t, size_t) { return e; }
+};
+
+template<int V>
+struct _Part<ndconst<V>>
+{
+    using type = ndconst<V>;
+    static type run(const type& e, size_t, size_t, size_t) { return e; }
+};
+
+template<class T, size_t N>
+struct _Part<ndslice<array_view<T>, N>>
+{
+    using type = ndslice<array_view<T>, N>;
+    static type run(const type& e, size_t axis, size_t first, size_t count) { return detail::section(e, axis, first, count); }
+};
+
+template<class T, size_t N>
+struct _Part<ndarray<T, N>>
+{
+    using type = ndslice<array_view<T>, N>;
+    static type run(const ndarray<T, N>& e, size_t axis, size_t first, size_t count) { return detail::section(e, axis, first, count); }
+};
+
+template<class T, size_t N>
+struct _Part<ndchunked<T, N>>
+{
+    using type = ndslice<array_view<T>, N>;
+
+    static type run(const ndchunked<T, N>& e, size_t, size_t first, size_t count)
+    {
+        const auto& offsets = e.offsets();
+        const auto  k = size_t(std::upper_bound(offsets.begin(), offsets.end(), first) - offsets.begin()) - 1;
+        return detail::section(e.parts()[k], e.axis(), first - offsets[k], count);
+    }
+};
+
+template<class F, class A>
+struct _Part<ndview<F, A>>
+{
+    using type = ndview<F, typename _Part<A>::type>;
+    static type run(const ndview<F, A>& e, size_t axis, size_t first, size_t count) { return{ _Part<A>::run(e.a, axis, first, count) }; }
+};
+
+template<class F, class A, class B>
+struct _Part<ndview<F, A, B>>
+{
+    using type = ndview<F, typename _Part<A>::type, typename _Part<B>::type>;
+    static type run(const ndview<F, A, B>& e, size_t axis, size_t first, size_t count) { return{ _Part<A>::run(e.a, axis, first, count), _Part<B>::run(e.b, axis, first, count) }; }
+};
+
+template<class F, class A, class B, class C>
+struct _Part<ndview<F, A, B, C>>
+{
+    using type = ndview<F, typename _Part<A>::type, typename _Part<B>::type, typename _Part<C>::type>;
+    static type run(const ndview<F, A, B, C>& e, size_t axis, size_t first, size_t count) { return{ _Part<A>::run(e.a, axis, first, count), _Part<B>::run(e.b, axis, first, count), _Part<C>::run(e.c, axis, first, count) }; }
+};
+
+namespace detail
+{
+// where the ndchunked operands of an expression change part, along `axis`.
+struct chunk_layout
+{
+    size_t              axis   = 0;
+    size_t              length = 0;     // along axis
+    bool                mixed  = false; // split along different axes
+    std::vector<size_t> bounds;         // part offsets, sorted, from 0 to length
+};
+}
+
+// _Bounds<E>::add(e, layout): the part offsets of every ndchunked in E.
+template<class E>
+struct _Bounds
+{
+    static void add(const E&, detail::chunk_layout&) {}
+};
+
+template<class T, size_t N>
+struct _Bounds<ndchunked<T, N>>
+{
+    static void add(const ndchunked<T, N>& e, detail::chunk_layout& layout)
+    {
+        const auto length = e.shape()[e.axis()];
+        if (layout.bounds.empty()) {
+            layout.axis   = e.axis();
+            layout.length = length;
+        }
+        else if (e.axis() != layout.axis) {
+            layout.mixed = true;
+        }
+        else if (length != layout.length) {
+            throw std::invalid_argument("lumpy: concatenated operands differ in length");
+        }
+        layout.bounds.insert(layout.bounds.end(), e.offsets().begin(), e.offsets().end());
+    }
+};
+
+template<class F, class A>
+struct _Bounds<ndview<F, A>>
+{
+    static void add(const ndview<F, A>& e, detail::chunk_layout& layout)
+    {
+        _Bounds<A>::add(e.a, layout);
+    }
+};
+
+template<class F, class A, class B>
+struct _Bounds<ndview<F, A, B>>
+{
+    static void add(const ndview<F, A, B>& e, detail::chunk_layout& layout)
+    {
+        _Bounds<A>::add(e.a, layout);
+        _Bounds<B>::add(e.b, layout);
+    }
+};
+
+template<class F, class A, class B, class C>
+struct _Bounds<ndview<F, A, B, C>>
+{
+    static void add(const ndview<F, A, B, C>& e, detail::chunk_layout& layout)
+    {
+        _Bounds<A>::add(e.a, layout);
+        _Bounds<B>::add(e.b, layout);
+        _Bounds<C>::add(e.c, layout);
+    }
+};
+
+template<class E>
+detail::chunk_layout chunks_of(const E& expr)
+{
+    detail::chunk_layout layout;
+    _Bounds<E>::add(expr, layout);
+
+    auto& bounds = layout.bounds;
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+    return layout;
+}
+#pragma endregion
+
+#pragma region ascontiguous
+// a contiguous ndarray with the elements of `s`; `s` itself when it already is one and owns
+// its elements.
+template<class T, size_t N>
+ndarray<T, N> ascontiguous(const ndarray<T, N>& s)
+{
+    return s.sdata() != nullptr && detail::is_contiguous(s) ? s : detail::copy_of<T, N>(s);
+}
+
+// a slice owns nothing, so this is always a copy, even of contiguous elements.
+template<class T, size_t N>
+ndarray<T, N> ascontiguous(const ndslice<array_view<T>, N>& s)
+{
+    return detail::copy_of(s);
+}
+
+namespace detail
+{
+template<class T, size_t N>
+ndarray<T, N> copy_of(const ndchunked<T, N>& s)
+{
+    lumpy_trace("ascontiguous.chunked", trace::split(task_count(s.size(), copy_grain, thread_count())), s.size(), 2 * s.size() * sizeof(T));
+
+    ndarray<T, N> result(s.shape()._elements);
+    s.copy_to(result);
+    return result;
+}
+}
+
+template<class T, size_t N>
+ndarray<T, N> ascontiguous(const ndchunked<T, N>& s)
+{
+    // a part given as a slice is only a view, and is copied like the rest.
+    if (s.parts().size() == 1 && s.parts()[0].sdata() != nullptr && detail::is_contiguous(s.parts()[0])) return s.parts()[0];
+    return detail::copy_of(s);
+}
+
+// out = s, part by part, rather than element by element through the expression path.
+template<class T, size_t N>
+void assign(const ndslice<array_view<T>, N>& out, const ndchunked<T, N>& s)
+{
+    lumpy_trace("assign.chunked", trace::split(task_count(s.size(), detail::copy_grain, thread_count())), s.size(), 2 * s.size() * sizeof(T));
+    s.copy_to(out);
+}
+#pragma endregion
+
+#pragma region concatenate
+// lazy: the parts are kept where they are, see ndchunked.
+template<class T, size_t N>
+ndchunked<T, N> chunked_concatenate(const std::vector<ndarray<T, N>>& parts, size_t axis = 0)
+{
+    return{ parts, axis };
+}
+
+template<class T, size_t N>
+ndchunked<T, N> chunked_concatenate(const std::vector<ndslice<array_view<T>, N>>& parts, size_t axis = 0)
+{
+    return{ parts, axis };
+}
+
+template<class T, size_t N>
+ndchunked<T, N + 1> chunked_stack(const std::vector<ndarray<T, N>>& parts, size_t axis = 0)
+{
+    ndchunked<T, N + 1> result(axis);
+    for (auto& part : parts) result.append(detail::expand(part, axis));
+    return result;
+}
+
+template<class T, size_t N>
+ndchunked<T, N + 1> chunked_stack(const std::vector<ndslice<array_view<T>, N>>& parts, size_t axis = 0)
+{
+    ndchunked<T, N + 1> result(axis);
+    for (auto& part : parts) result.append(detail::expand(ndarray<T, N>(part, nullptr), axis));
+    return result;
+}
+
+// eager: one new contiguous array, filled by a parallel copy; never one of the parts, even
+// when there is only one.
+template<class T, size_t N>
+ndarray<T, N> concatenate(const std::vector<ndarray<T, N>>& parts, size_t axis = 0)
+{
+    return detail::copy_of(chunked_concatenate(parts, axis));
+}
+
+template<class T, size_t N>
+ndarray<T, N> concatenate(const std::vector<ndslice<array_view<T>, N>>& parts, size_t axis = 0)
+{
+    return detail::copy_of(chunked_concatenate(parts, axis));
+}
+
+template<class T, size_t N>
+ndarray<T, N> concatenate(std::initializer_list<ndarray<T, N>> parts, size_t axis = 0)
+{
+    return concatenate(std::vector<ndarray<T, N>>(parts), axis);
+}
+
+template<class T, size_t N>
+ndarray<T, N> concatenate(std::initializer_list<ndslice<array_view<T>, N>> parts, size_t axis = 0)
+{
+    return concatenate(std::vector<ndslice<array_view<T>, N>>(parts), axis);
+}
+
+template<class T, size_t N>
+ndarray<T, N + 1> stack(const std::vector<ndarray<T, N>>& parts, size_t axis = 0)
+{
+    return detail::copy_of(chunked_stack(parts, axis));
+}
+
+template<class T, size_t N>
+ndarray<T, N + 1> stack(const std::vector<ndslice<array_view<T>, N>>& parts, size_t axis = 0)
+{
+    return detail::copy_of(chunked_stack(parts, axis));
+}
+
+template<class T, size_t N>
+ndarray<T, N + 1> stack(std::initializer_list<ndarray<T, N>> parts, size_t axis = 0)
+{
+    return stack(std::vector<ndarray<T, N>>(parts), axis);
+}
+
+template<class T, size_t N>
+ndarray<T, N + 1> stack(std::initializer_list<ndslice<array_view<T>, N>> parts, size_t axis = 0)
+{
+    return stack(std::vector<ndslice<array_view<T>, N>>(parts), axis);
+}
+#pragma endregion
+
+}
+
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+#pragma region dtype
+// element types a dyn_array can hold; a dtype is the position of its type in this list.
+using dtypes = types_t<bool, std::int8_t, std::uint8_t, std::int16_t, std::uint16_t, std::int32_t, std::uint32_t,
+                       std::int64_t, std::uint64_t, float, double>;
+
+enum class dtype : uchar
+{
+    b8, i8, u8, i16, u16, i32, u32, i64, u64, f32, f64
+};
+
+template<dtype D>
+using dtype_t = type_at<size_t(D), dtypes>;
+
+namespace detail
+{
+template<size_t Size, bool Signed> struct _Sized_Int;
+template<> struct _Sized_Int<1, true>  { using type = std::int8_t;   };
+template<> struct _Sized_Int<1, false> { using type = std::uint8_t;  };
+template<> struct _Sized_Int<2, true>  { using type = std::int16_t;  };
+template<> struct _Sized_Int<2, false> { using type = std::uint16_t; };
+template<> struct _Sized_Int<4, true>  { using type = std::int32_t;  };
+template<> struct _Sized_Int<4, false> { using type = std::uint32_t; };
+template<> struct _Sized_Int<8, true>  { using type = std::int64_t;  };
+template<> struct _Sized_Int<8, false> { using type = std::uint64_t; };
+
+// integer types are matched by size and sign, so long/long long and size_t all find their dtype.
+template<class T, bool = is_integral<T> && !is_same<T, bool>>
+struct _Dtype_Key
+{
+    using type = T;
+};
+
+template<class T>
+struct _Dtype_Key<T, true> : _Sized_Int<sizeof(T), std::is_signed<T>::value>
+{};
+}
+
+template<class T>
+constexpr dtype dtype_of()
+{
+    using key = typename detail::_Dtype_Key<remove_cv<T>>::type;
+    static_assert(index_of<key, dtypes> < dtypes::size, "lumpy: type has no dtype");
+    return dtype(index_of<key, dtypes>);
+}
+
+namespace detail
+{
+template<class ...Ts>
+constexpr size_t dtype_size(dtype type, types_t<Ts...>)
+{
+    constexpr size_t sizes[] = { sizeof(Ts)... };
+    return sizes[size_t(type)];
+}
+
+template<class ...Ts>
+constexpr size_t dtype_align(dtype type, types_t<Ts...>)
+{
+    constexpr size_t aligns[] = { alignof(Ts)... };
+    return aligns[size_t(type)];
+}
+
+template<class ...Ts>
+constexpr bool dtype_float(dtype type, types_t<Ts...>)
+{
+    constexpr bool floats[] = { is_float<Ts>... };
+    return floats[size_t(type)];
+}
+}
+
+constexpr size_t    dtype_size (dtype type) { return detail::dtype_size (type, dtypes{}); }
+constexpr size_t    dtype_align(dtype type) { return detail::dtype_align(type, dtypes{}); }
+constexpr bool      dtype_float(dtype type) { return detail::dtype_float(type, dtypes{}); }
+
+namespace detail
+{
+// byte order prefix of the host in numpy type strings.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr char native_order = '>';
+#else
+constexpr char native_order = '<';
+#endif
+}
+
+// dtype from a numpy type string ("<f4", "|u1", "i8", ...). elements are never byte swapped,
+// so a multi-byte type in the other byte order ('>' on a little-endian host) is rejected.
+inline dtype to_dtype(const string& descr)
+{
+    auto code  = descr;
+    auto order = '=';
+    if (!code.empty() && (code[0] == '<' || code[0] == '>' || code[0] == '|' || code[0] == '=')) {
+        order = code[0];
+        code  = code.substr(1);
+    }
+
+    auto check = [&](dtype type) {
+        if ((order == '<' || order == '>') && order != detail::native_order && dtype_size(type) > 1) {
+            throw std::invalid_argument("lumpy: dtype '" + descr + "' is not in the host byte order");
+        }
+        return type;
+    };
+
+    if (code == "?" || code == "b1")    return check(dtype::b8);
+    if (code == "i1")                   return check(dtype::i8);
+    if (code == "u1")                   return check(dtype::u8);
+    if (code == "i2")                   return check(dtype::i16);
+    if (code == "u2")                   return check(dtype::u16);
+    if (code == "i4")                   return check(dtype::i32);
+    if (code == "u4")                   return check(dtype::u32);
+    if (code == "i8")                   return check(dtype::i64);
+    if (code == "u8")                   return check(dtype::u64);
+    if (code == "f4")                   return check(dtype::f32);
+    if (code == "f8")                   return check(dtype::f64);
+    throw std::invalid_argument("lumpy: unsupported dtype '" + descr + "'");
+}
+#pragma endregion
+
+#pragma region dyn_array
+// an ndarray whose element type and rank are only known at runtime.
+// it is turned back into a typed ndslice once per operation, by visit(), so kernels
+// still run on the templated ndslice/ndview code with no per-element dispatch.
+class dyn_array
+{
+public:
+    static constexpr size_t max_rank = 4;
+
+    dyn_array(dtype type, const std::vector<size_t>& shape)
+        : _type(type)
+        , _shape(shape)
+    {
+        check_rank();
+        auto bytes = dtype_size(type) * size();
+        _sdata = std::shared_ptr<void>(new ubyte[bytes], std::default_delete<ubyte[]>());
+        _stride = contiguous_stride();
+    }
+
+    // wrap memory owned elsewhere (a loaded .npy, a network buffer, ...).
+    dyn_array(dtype type, const std::vector<size_t>& shape, std::shared_ptr<void> sdata)
+        : _type(type)
+        , _shape(shape)
+        , _sdata(sdata)
+    {
+        check_rank();
+        _stride = contiguous_stride();
+    }
+
+    template<class T, size_t N>
+    dyn_array(const ndarray<T, N>& value)
+        : _type(dtype_of<T>())
+        , _shape(value.shape()._elements, value.shape()._elements + N)
+        , _stride(value.stride()._elements, value.stride()._elements + N)
+        , _sdata(value.sdata(), &value.data()[0])
+    {
+        static_assert(N >= 1 && N <= max_rank, "lumpy: dyn_array rank must be 1..max_rank");
+    }
+
+public:
+    dtype   type()                  const noexcept { return _type; }
+    size_t  rank()                  const noexcept { return _shape.size(); }
+    auto&   shape()                 const noexcept { return _shape; }
+    auto&   stride()                const noexcept { return _stride; }
+    void*   data()                  const noexcept { return _sdata.get(); }
+
+    size_t  size() const noexcept
+    {
+        size_t count = 1;
+        for (auto n : _shape) count *= n;
+        return count;
+    }
+
+    // typed view of the elements, T and N must match type() and rank().
+    template<class T, size_t N>
+    ndslice<array_view<T>, N> as() const
+    {
+        if (dtype_of<T>() != _type || N != rank()) {
+            throw std::invalid_argument("lumpy: dyn_array accessed with the wrong type or rank");
+        }
+
+        // one past the furthest element; nothing when a dimension is empty.
+        array<size_t, N> shape, stride;
+        size_t extent = size() == 0 ? 0 : 1;
+        for (size_t i = 0; i < N; ++i) {
+            shape[i]  = _shape[i];
+            stride[i] = _stride[i];
+            if (extent != 0) extent += (_shape[i] - 1) * _stride[i];
+        }
+        return{ array_view<T>(static_cast<T*>(_sdata.get()), extent), shape, stride };
+    }
+
+    // typed array sharing the elements.
+    template<class T, size_t N>
+    ndarray<T, N> as_array() const
+    {
+        return{ as<T, N>(), std::shared_ptr<T>(_sdata, static_cast<T*>(_sdata.get())) };
+    }
+
+private:
+    dtype                   _type;
+    std::vector<size_t>     _shape;
+    std::vector<size_t>     _stride;
+    std::shared_ptr<void>   _sdata;
+
+    void check_rank() const
+    {
+        if (_shape.empty() || _shape.size() > max_rank) {
+            throw std::invalid_argument("lumpy: dyn_array rank must be 1.." + std::to_string(max_rank));
+        }
+    }
+
+    std::vector<size_t> contiguous_stride() const
+    {
+        std::vector<size_t> stride(_shape.size());
+        size_t step = 1;
+        for (size_t i = 0; i < _shape.size(); ++i) {
+            stride[i] = step;
+            step     *= _shape[i];
+        }
+        return stride;
+    }
+};
+#pragma endregion
+
+#pragma region visit
+namespace detail
+{
+template<class T, class F>
+decltype(auto) visit_rank(const dyn_array& value, F&& func)
+{
+    switch (value.rank()) {
+    case 1: return func(value.as<T, 1>());
+    case 2: return func(value.as<T, 2>());
+    case 3: return func(value.as<T, 3>());
+    case 4: return func(value.as<T, 4>());
+    }
+    throw std::invalid_argument("lumpy: dyn_array rank must be 1..4");
+}
+}
+
+// call func(ndslice<array_view<T>, N>) with the element type and rank of `value`.
+// the switch runs once per call; func is instantiated for every dtype and rank, so it
+// must return the same type for all of them (dyn_array, a scalar, void, ...).
+template<class F>
+decltype(auto) visit(const dyn_array& value, F&& func)
+{
+    switch (value.type()) {
+    case dtype::b8:  return detail::visit_rank<dtype_t<dtype::b8 >>(value, func);
+    case dtype::i8:  return detail::visit_rank<dtype_t<dtype::i8 >>(value, func);
+    case dtype::u8:  return detail::visit_rank<dtype_t<dtype::u8 >>(value, func);
+    case dtype::i16: return detail::visit_rank<dtype_t<dtype::i16>>(value, func);
+    case dtype::u16: return detail::visit_rank<dtype_t<dtype::u16>>(value, func);
+    case dtype::i32: return detail::visit_rank<dtype_t<dtype::i32>>(value, func);
+    case dtype::u32: return detail::visit_rank<dtype_t<dtype::u32>>(value, func);
+    case dtype::i64: return detail::visit_rank<dtype_t<dtype::i64>>(value, func);
+    case dtype::u64: return detail::visit_rank<dtype_t<dtype::u64>>(value, func);
+    case dtype::f32: return detail::visit_rank<dtype_t<dtype::f32>>(value, func);
+    case dtype::f64: return detail::visit_rank<dtype_t<dtype::f64>>(value, func);
+    }
+    throw std::invalid_argument("lumpy: unknown dtype");
+}
+#pragma endregion
+
+}
+
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <lumpy/core.h>
+#include <lumpy/math/view.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+#include <lumpy/math/concat.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+namespace detail
+{
+constexpr size_t eval_grain = 1 << 14;  // elements per task
+
+template<class E, size_t N, size_t ...Is>
+constexpr auto eval_at(const E& expr, const array<size_t, N>& index, indexs_t<Is...>)
+{
+    return expr(index[Is]...);
+}
+
+// out(i...) = expr(i...) for the elements [first, last) of `out`, in the order of its runs.
+template<class T, size_t N, class E>
+void assign_range(const ndslice<array_view<T>, N>& out, const E& expr, size_t first, size_t last)
+{
+    const auto& shape  = out.shape();
+    const auto  stride = out.stride()[0];
+
+    for_each_run(out, first, last, [&](size_t offset, size_t position, size_t count) {
+        array<size_t, N> index;
+        for (size_t i = 0; i < N; ++i) {
+            index[i]  = position % shape[i];
+            position /= shape[i];
+        }
+
+        auto data = &out.data()[offset];
+        for (size_t i = 0; i < count; ++i, ++index[0]) {
+            data[i * stride] = T(eval_at(expr, index, to_indexs<N>{}));
+        }
+    });
+}
+
+// the shared plan, a block of elements of each run at a time.
+template<class T, size_t N, class Tree, class ...Gs, size_t ...Is>
+void assign_range(const ndslice<array_view<T>, N>& out, const ndlet<Tree, Gs...>& plan, size_t first, size_t last, indexs_t<Is...>)
+{
+    using plan_t = ndlet<Tree, Gs...>;
+
+    const auto& shape  = out.shape();
+    const auto  stride = out.stride()[0];
+
+    typename plan_t::template values_t<N> values;
+
+    for_each_run(out, first, last, [&](size_t offset, size_t position, size_t count) {
+        array<size_t, N> index;
+        for (size_t i = 0; i < N; ++i) {
+            index[i]  = position % shape[i];
+            position /= shape[i];
+        }
+
+        auto data = &out.data()[offset];
+        for (size_t done = 0; done < count; ) {
+            const auto n = std::min(count - done, plan_t::block);
+            plan.load(values, n, index[Is]...);
+            for (size_t k = 0; k < n; ++k, ++index[0]) {
+                data[(done + k) * stride] = T(plan.at(values, k, index[Is]...));
+            }
+            done += n;
+        }
+    });
+}
+
+template<class T, size_t N, class Tree, class ...Gs>
+void assign_range(const ndslice<array_view<T>, N>& out, const ndlet<Tree, Gs...>& plan, size_t first, size_t last)
+{
+    assign_range(out, plan, first, last, to_indexs<N>{});
+}
+
+// func(expr), or func(share(expr)) when some occurrences in it are the same expression.
+template<class E, class F>
+static_if<!can_share<E>> with_shared(const E& expr, F&& func)
+{
+    func(expr);
+}
+
+template<class E, class F>
+static_if<can_share<E>> with_shared(const E& expr, F&& func)
+{
+    const auto plan = share(expr);
+    if (plan.shared()) {
+        func(plan);
+    }
+    else {
+        func(expr);
+    }
+}
+
+template<class T, size_t N, class E>
+void assign_all(const ndslice<array_view<T>, N>& out, const E& expr)
+{
+    with_shared(expr, [&](const auto& e) {
+        parallel_for(out.size(), eval_grain, [&](size_t, size_t first, size_t last) {
+            assign_range(out, e, first, last);
+        });
+    });
+}
+
+template<class T, size_t N, class E>
+static_if<!has_chunked<E>> assign_parts(const ndslice<array_view<T>, N>& out, const E& expr)
+{
+    assign_all(out, expr);
+}
+
+// with ndchunked operands, `out` is cut wherever one of them changes part, and each piece
+// gets the expression restricted to it, where the parts are plain slices. operands split
+// along different axes are read element by element instead.
+template<class T, size_t N, class E>
+static_if<has_chunked<E>> assign_parts(const ndslice<array_view<T>, N>& out, const E& expr)
+{
+    const auto layout = chunks_of(expr);
+    if (layout.mixed) {
+        assign_all(out, expr);
+        return;
+    }
+
+    const auto  axis   = layout.axis;
+    const auto& bounds = layout.bounds;
+    if (layout.length != out.shape()[axis]) {
+        throw std::invalid_argument("lumpy: concatenated operand does not match the output");
+    }
+    if (out.size() == 0) return;
+
+    // the pieces are consecutive ranges of `lane` elements per index along axis.
+    const auto lane = out.size() / out.shape()[axis];
+
+    parallel_for(out.size(), eval_grain, [&](size_t, size_t first, size_t last) {
+        auto k = size_t(std::upper_bound(bounds.begin(), bounds.end(), first / lane) - bounds.begin()) - 1;
+        for (; k + 1 < bounds.size() && bounds[k] * lane < last; ++k) {
+            const auto from   = bounds[k];
+            const auto count  = bounds[k + 1] - from;
+            const auto target = section(out, axis, from, count);
+            const auto part   = _Part<E>::run(expr, axis, from, count);
+
+            with_shared(part, [&](const auto& e) {
+                assign_range(target, e, std::max(first, from * lane) - from * lane, std::min(last, (from + count) * lane) - from * lane);
+            });
+        }
+    });
+}
+}
+
+// out(i...) = expr(i...) for every element of `out`. the expression is simplify()-ed and its
+// repeated subexpressions share()-d, then evaluated one element at a time, split over
+// threads along the runs of axis 0; with ndchunked operands, one part at a time.
+template<class T, size_t N, class E, class = static_if<is_expr<E>> >
+void assign(const ndslice<array_view<T>, N>& out, const E& expr)
+{
+    lumpy_trace("assign", trace::split(task_count(out.size(), detail::eval_grain, thread_count())), out.size(), out.size() * sizeof(T));
+
+    detail::assign_parts(out, simplify(expr));
+}
+
+template<class T, size_t N, class E, class = static_if<is_expr<E>> >
+ndarray<T, N> eval(const size_t(&shape)[N], const E& expr)
+{
+    ndarray<T, N> result(shape);
+    assign(result, expr);
+    return result;
+}
+
+}
+
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+#include <lumpy/math/sort.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+// counting kernels. every task counts into its own private bins, and the bins are summed
+// once at the end, so no counter is ever shared between threads.
+namespace detail
+{
+constexpr size_t count_grain   = 1 << 16;   // elements per task
+constexpr size_t index_block   = 256;       // bin indexs computed per batch
+constexpr size_t unique_sorted = 1 << 20;   // unique() sorts below this size, hashes above
+
+// run func(bins, offset, count) over every run of `s`, with per-task bins of `nbins`
+// counters, and return the summed bins.
+template<class T, size_t N, class F>
+ndarray<size_t, 1> count_bins(const ndslice<array_view<T>, N>& s, size_t nbins, F&& func)
+{
+    std::vector<std::vector<size_t>> local(thread_count());
+    lumpy_trace_alloc(task_count(s.size(), count_grain, thread_count()) * nbins * sizeof(size_t));
+
+    parallel_for(s.size(), count_grain, [&](size_t task, size_t first, size_t last) {
+        auto& bins = local[task];
+        bins.assign(nbins, 0);
+        for_each_run(s, first, last, [&](size_t offset, size_t, size_t count) {
+            func(bins.data(), offset, count);
+        });
+    });
+
+    ndarray<size_t, 1> result({ nbins });
+    auto out = &result.data()[0];
+    parallel_for(nbins, count_grain, [&](size_t, size_t first, size_t last) {
+        for (auto i = first; i < last; ++i) {
+            size_t total = 0;
+            for (auto& bins : local) total += bins.empty() ? 0 : bins[i];
+            out[i] = total;
+        }
+    });
+    return result;
+}
+}
+
+#pragma region bincount
+// number of occurrences of each value 0..max(s), at least `minlength` bins; values must not be
+// negative.
+template<class T, size_t N, class = static_if<is_integral<T>> >
+ndarray<size_t, 1> bincount(const ndslice<array_view<T>, N>& s, size_t minlength = 0)
+{
+    const auto stride = s.stride()[0];
+
+    lumpy_trace("bincount", trace::split(task_count(s.size(), detail::count_grain, thread_count())), s.size(), 2 * s.size() * sizeof(T));
+
+    // max(s) + 1 per task, 0 for no elements.
+    std::vector<size_t> highest(thread_count(), 0);
+    std::vector<T>      lowest(thread_count(), T(0));
+    parallel_for(s.size(), detail::count_grain, [&](size_t task, size_t first, size_t last) {
+        auto high = T(0), low = T(0);
+        for_each_run(s, first, last, [&](size_t offset, size_t, size_t count) {
+            auto in = &s.data()[offset];
+            for (size_t i = 0; i < count; ++i) {
+                high = std::max(high, in[i * stride]);
+                low  = std::min(low, in[i * stride]);
+            }
+        });
+        highest[task] = size_t(high) + 1;
+        lowest[task]  = low;
+    });
+
+    if (*std::min_element(lowest.begin(), lowest.end()) < T(0)) {
+        throw std::invalid_argument("lumpy: bincount needs non-negative values");
+    }
+    const auto nbins = std::max(minlength, *std::max_element(highest.begin(), highest.end()));
+
+    return detail::count_bins(s, nbins, [&](size_t* bins, size_t offset, size_t count) {
+        auto in = &s.data()[offset];
+        for (size_t i = 0; i < count; ++i) ++bins[size_t(in[i * stride])];
+    });
+}
+#pragma endregion
+
+#pragma region histogram
+// `nbins` equal bins over [lo, hi]; hi itself falls into the last bin, values outside are dropped.
+template<class T, size_t N>
+ndarray<size_t, 1> histogram(const ndslice<array_view<T>, N>& s, size_t nbins, double lo, double hi)
+{
+    if (nbins == 0 || !(lo < hi)) {
+        throw std::invalid_argument("lumpy: histogram needs nbins > 0 and lo < hi");
+    }
+
+    const auto stride = s.stride()[0];
+    const auto scale  = double(nbins) / (hi - lo);
+
+    lumpy_trace("histogram", trace::split(task_count(s.size(), detail::count_grain, thread_count()), trace::path::simd), s.size(), s.size() * sizeof(T));
+
+    // out of range values go to an extra bin at the end, which is sliced off.
+    auto result = detail::count_bins(s, nbins + 1, [&](size_t* bins, size_t offset, size_t count) {
+        auto in = &s.data()[offset];
+
+        size_t index[detail::index_block];
+        for (size_t first = 0; first < count; first += detail::index_block) {
+            const auto block = std::min(detail::index_block, count - first);
+
+            // branch-free, so the compiler vectorizes the index computation.
+            for (size_t i = 0; i < block; ++i) {
+                auto value = double(in[(first + i) * stride]);
+                auto bin   = (value - lo) * scale;
+                auto k     = size_t(bin < 0.0 ? 0.0 : (bin < double(nbins) ? bin : double(nbins - 1)));
+                index[i]   = value >= lo && value <= hi ? k : nbins;
+            }
+            for (size_t i = 0; i < block; ++i) {
+                ++bins[index[i]];
+            }
+        }
+    });
+
+    return result.slice({ 0, nbins - 1 });
+}
+
+// bins between consecutive edges, which must not decrease; the last bin includes its right edge.
+template<class T, size_t N, class E>
+ndarray<size_t, 1> histogram(const ndslice<array_view<T>, N>& s, const ndslice<array_view<E>, 1>& edges)
+{
+    const auto stride = s.stride()[0];
+    const auto nedges = edges.shape()[0];
+    if (nedges < 2) {
+        throw std::invalid_argument("lumpy: histogram needs at least two edges");
+    }
+    const auto nbins  = nedges - 1;
+
+    lumpy_trace("histogram.edges", trace::split(task_count(s.size(), detail::count_grain, thread_count())), s.size(), s.size() * sizeof(T));
+
+    std::vector<double> bounds(nedges);
+    for (size_t i = 0; i < nedges; ++i) bounds[i] = double(edges(i));
+    for (size_t i = 1; i < nedges; ++i) {
+        if (!(bounds[i - 1] <= bounds[i])) {
+            throw std::invalid_argument("lumpy: histogram edges must be increasing");
+        }
+    }
+
+    auto result = detail::count_bins(s, nbins + 1, [&](size_t* bins, size_t offset, size_t count) {
+        auto in = &s.data()[offset];
+        for (size_t i = 0; i < count; ++i) {
+            auto value = double(in[i * stride]);
+            auto k     = size_t(std::upper_bound(bounds.begin(), bounds.end(), value) - bounds.begin());
+            k = value == bounds.back() ? nbins : k;
+            ++bins[k == 0 || k > nbins ? nbins : k - 1];
+        }
+    });
+
+    return result.slice({ 0, nbins - 1 });
+}
+#pragma endregion
+
+#pragma region unique
+// sorted distinct values of `s` and how often each occurs.
+template<class T, size_t N>
+std::pair<ndarray<T, 1>, ndarray<size_t, 1>> unique(const ndslice<array_view<T>, N>& s)
+{
+    const auto stride = s.stride()[0];
+    const auto total  = s.size();
+
+    std::vector<std::pair<T, size_t>> counts;
+
+    lumpy_trace("unique", trace::split(total < detail::unique_sorted ? 1 : task_count(total, detail::count_grain, thread_count())), total, total * sizeof(T));
+
+    if (total < detail::unique_sorted) {
+        // small: sort a copy, then count runs.
+        std::vector<T> values(total);
+        for_each_run(s, 0, total, [&](size_t offset, size_t index, size_t count) {
+            auto in = &s.data()[offset];
+            for (size_t i = 0; i < count; ++i) values[index + i] = in[i * stride];
+        });
+        std::sort(values.begin(), values.end());
+
+        for (size_t i = 0; i < total; ) {
+            auto j = i;
+            while (j < total && values[j] == values[i]) ++j;
+            counts.emplace_back(values[i], j - i);
+            i = j;
+        }
+    }
+    else {
+        // large: per-task hash tables, merged and then sorted by key.
+        std::vector<std::unordered_map<T, size_t>> local(thread_count());
+        parallel_for(total, detail::count_grain, [&](size_t task, size_t first, size_t last) {
+            auto& table = local[task];
+            for_each_run(s, first, last, [&](size_t offset, size_t, size_t count) {
+                auto in = &s.data()[offset];
+                for (size_t i = 0; i < count; ++i) ++table[in[i * stride]];
+            });
+        });
+
+        auto& merged = local[0];
+        for (size_t i = 1; i < local.size(); ++i) {
+            for (auto& item : local[i]) merged[item.first] += item.second;
+        }
+        counts.assign(merged.begin(), merged.end());
+        detail::parallel_sort(counts.data(), counts.size(), [](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) {
+            return a.first < b.first;
+        });
+    }
+
+    ndarray<T, 1>       values({ counts.size() });
+    ndarray<size_t, 1>  occurs({ counts.size() });
+    for (size_t i = 0; i < counts.size(); ++i) {
+        values.data()[i] = counts[i].first;
+        occurs.data()[i] = counts[i].second;
+    }
+    return{ values, occurs };
+}
+#pragma endregion
+
+}
+
+}
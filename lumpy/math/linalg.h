@@ -0,0 +1,601 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+// dense factorizations of 2-d arrays. m(i, j) is row i, column j; axis 0 is the contiguous
+// one, so a matrix is column-major with leading dimension shape()[0], as in lapack.
+//
+// every factorization is blocked: a narrow panel is factored column by column, and the rest
+// of the matrix is updated through gemm_sub, which does nearly all the flops on all threads.
+namespace detail
+{
+constexpr size_t panel_size = 64;       // columns per panel
+constexpr size_t gemm_rows  = 256;      // rows of `a` gemm_sub keeps in cache at a time
+constexpr size_t gemm_grain = 1 << 18;  // multiply-adds per task
+
+// c (m x n) -= a (m x k) * b (k x n). a and c are column-major with leading dimensions lda and
+// ldc, b(p, j) is b[p*bp + j*bj], so a transposed b costs nothing. when `lower`, only rows >= j
+// of column j need to be right (the rest of its 4-column group may be touched too).
+template<class T>
+void gemm_sub(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t bp, size_t bj, T* c, size_t ldc, bool lower = false)
+{
+    if (m == 0 || n == 0 || k == 0) return;
+
+    // columns of c go in groups of 4, so each load of `a` feeds 4 multiply-adds.
+    const auto groups = (n + 3) / 4;
+    const auto grain  = std::max(size_t(1), gemm_grain / (4 * m * k));
+
+    parallel_for(groups, grain, [&](size_t, size_t first, size_t last) {
+        for (size_t r0 = 0; r0 < m; r0 += gemm_rows) {
+            const auto r1 = std::min(m, r0 + gemm_rows);
+
+            for (auto group = first; group < last; ++group) {
+                const auto j    = group * 4;
+                const auto cols = std::min(size_t(4), n - j);
+                const auto lo   = lower ? std::max(r0, j) : r0;
+                if (lo >= r1) continue;
+
+                if (cols == 4) {
+                    auto c0 = c + j * ldc, c1 = c0 + ldc, c2 = c1 + ldc, c3 = c2 + ldc;
+                    for (size_t p = 0; p < k; ++p) {
+                        const auto ap = a + p * lda;
+                        const auto b0 = b[p * bp + (j + 0) * bj];
+                        const auto b1 = b[p * bp + (j + 1) * bj];
+                        const auto b2 = b[p * bp + (j + 2) * bj];
+                        const auto b3 = b[p * bp + (j + 3) * bj];
+                        for (auto i = lo; i < r1; ++i) {
+                            const auto v = ap[i];
+                            c0[i] -= v * b0;
+                            c1[i] -= v * b1;
+                            c2[i] -= v * b2;
+                            c3[i] -= v * b3;
+                        }
+                    }
+                }
+                else {
+                    for (auto jj = j; jj < j + cols; ++jj) {
+                        auto cj = c + jj * ldc;
+                        for (size_t p = 0; p < k; ++p) {
+                            const auto ap = a + p * lda;
+                            const auto bv = b[p * bp + jj * bj];
+                            for (auto i = lo; i < r1; ++i) cj[i] -= ap[i] * bv;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// t * x = b in place for the n columns of b; t is m x m triangular. columns run in parallel.
+template<class T>
+void trsm_block(bool lower, bool unit, size_t m, size_t n, const T* t, size_t ldt, T* b, size_t ldb)
+{
+    if (m == 0) return;
+
+    parallel_for(n, std::max(size_t(1), gemm_grain / (m * m)), [&](size_t, size_t first, size_t last) {
+        for (auto j = first; j < last; ++j) {
+            auto x = b + j * ldb;
+            if (lower) {
+                for (size_t p = 0; p < m; ++p) {
+                    if (!unit) x[p] /= t[p + p * ldt];
+                    const auto v   = x[p];
+                    const auto col = t + p * ldt;
+                    for (auto i = p + 1; i < m; ++i) x[i] -= col[i] * v;
+                }
+            }
+            else {
+                for (auto p = m; p-- > 0; ) {
+                    if (!unit) x[p] /= t[p + p * ldt];
+                    const auto v   = x[p];
+                    const auto col = t + p * ldt;
+                    for (size_t i = 0; i < p; ++i) x[i] -= col[i] * v;
+                }
+            }
+        }
+    });
+}
+
+// blocked trsm_block: diagonal blocks are solved directly, everything off them by gemm_sub.
+template<class T>
+void trsm(bool lower, bool unit, size_t m, size_t n, const T* t, size_t ldt, T* b, size_t ldb)
+{
+    for (size_t k = 0; k < m; k += panel_size) {
+        const auto size = std::min(panel_size, m - k);
+        if (lower) {
+            trsm_block(true, unit, size, n, t + k + k * ldt, ldt, b + k, ldb);
+            gemm_sub(m - k - size, n, size, t + (k + size) + k * ldt, ldt, b + k, 1, ldb, b + k + size, ldb);
+        }
+        else {
+            const auto first = m - k - size;
+            trsm_block(false, unit, size, n, t + first + first * ldt, ldt, b + first, ldb);
+            gemm_sub(first, n, size, t + first * ldt, ldt, b + first, 1, ldb, b, ldb);
+        }
+    }
+}
+
+// p * a = l * u in place (m x n), with row i of p * a being row perm[i] of a.
+template<class T>
+void lu_inplace(size_t m, size_t n, T* a, size_t lda, size_t* perm, int& sign)
+{
+    const auto kmax = std::min(m, n);
+
+    for (size_t i = 0; i < m; ++i) perm[i] = i;
+    sign = 1;
+
+    for (size_t k = 0; k < kmax; k += panel_size) {
+        const auto size = std::min(panel_size, kmax - k);
+
+        // panel a[k:m, k:k+size]; pivots swap whole rows, so the rest of the matrix follows.
+        for (auto j = k; j < k + size; ++j) {
+            auto col = a + j * lda;
+
+            auto pivot = j;
+            for (auto i = j + 1; i < m; ++i) {
+                if (std::abs(col[i]) > std::abs(col[pivot])) pivot = i;
+            }
+            if (pivot != j) {
+                for (size_t c = 0; c < n; ++c) std::swap(a[j + c * lda], a[pivot + c * lda]);
+                std::swap(perm[j], perm[pivot]);
+                sign = -sign;
+            }
+            if (col[j] == T(0)) continue;
+
+            const auto scale = T(1) / col[j];
+            for (auto i = j + 1; i < m; ++i) col[i] *= scale;
+
+            for (auto c = j + 1; c < k + size; ++c) {
+                auto other   = a + c * lda;
+                const auto v = other[j];
+                for (auto i = j + 1; i < m; ++i) other[i] -= col[i] * v;
+            }
+        }
+
+        if (k + size >= n) continue;
+
+        // u12 = l11^-1 * a12, then a22 -= l21 * u12.
+        const auto a12 = a + k + (k + size) * lda;
+        trsm_block(true, true, size, n - k - size, a + k + k * lda, lda, a12, lda);
+        gemm_sub(m - k - size, n - k - size, size, a + (k + size) + k * lda, lda, a12, 1, lda, a12 + size, lda);
+    }
+}
+
+// a = l * l^T in place (n x n), l in the lower triangle; the upper triangle is left as is.
+template<class T>
+void cholesky_inplace(size_t n, T* a, size_t lda)
+{
+    for (size_t k = 0; k < n; k += panel_size) {
+        const auto size = std::min(panel_size, n - k);
+        const auto rest = n - k - size;
+        const auto d    = a + k + k * lda;
+
+        for (size_t j = 0; j < size; ++j) {
+            auto col = d + j * lda;
+            if (!(col[j] > T(0))) {
+                throw std::domain_error("lumpy: matrix is not positive definite");
+            }
+            col[j] = std::sqrt(col[j]);
+
+            const auto scale = T(1) / col[j];
+            for (auto i = j + 1; i < size; ++i) col[i] *= scale;
+
+            for (auto c = j + 1; c < size; ++c) {
+                auto other   = d + c * lda;
+                const auto v = col[c];
+                for (auto i = c; i < size; ++i) other[i] -= col[i] * v;
+            }
+        }
+
+        if (rest == 0) break;
+
+        // l21 = a21 * l11^-T, column by column, rows split over threads.
+        const auto l21 = d + size;
+        parallel_for(rest, std::max(size_t(1), gemm_grain / (size * size)), [&](size_t, size_t first, size_t last) {
+            for (size_t j = 0; j < size; ++j) {
+                auto col = l21 + j * lda;
+
+                const auto scale = T(1) / d[j + j * lda];
+                for (auto i = first; i < last; ++i) col[i] *= scale;
+
+                for (auto c = j + 1; c < size; ++c) {
+                    auto other   = l21 + c * lda;
+                    const auto v = d[c + j * lda];
+                    for (auto i = first; i < last; ++i) other[i] -= col[i] * v;
+                }
+            }
+        });
+
+        // a22 -= l21 * l21^T, lower triangle only.
+        gemm_sub(rest, rest, size, l21, lda, l21, lda, 1, l21 + size * lda, lda, true);
+    }
+}
+
+// householder reflectors of the panel a[k:m, k:k+size]: v below the diagonal (with an
+// implicit 1 on it), r on and above it, and tau[j] so that h_j = I - tau[j] * v * v^T.
+template<class T>
+void qr_panel(size_t m, T* a, size_t lda, size_t k, size_t size, T* tau)
+{
+    for (auto j = k; j < k + size; ++j) {
+        auto col = a + j * lda;
+
+        T norm = 0;
+        for (auto i = j + 1; i < m; ++i) norm += col[i] * col[i];
+
+        if (norm == T(0)) {
+            tau[j] = 0;
+            continue;
+        }
+
+        const auto alpha = col[j];
+        const auto beta  = -std::copysign(std::sqrt(alpha * alpha + norm), alpha);
+        tau[j] = (beta - alpha) / beta;
+
+        const auto scale = T(1) / (alpha - beta);
+        for (auto i = j + 1; i < m; ++i) col[i] *= scale;
+        col[j] = beta;
+
+        for (auto c = j + 1; c < k + size; ++c) {
+            auto other = a + c * lda;
+
+            auto w = other[j];
+            for (auto i = j + 1; i < m; ++i) w += col[i] * other[i];
+            w *= tau[j];
+
+            other[j] -= w;
+            for (auto i = j + 1; i < m; ++i) other[i] -= w * col[i];
+        }
+    }
+}
+
+// the reflectors of one panel as h = I - v * t * v^T (compact wy), so they are applied
+// to the rest of the matrix by two products instead of one rank-1 update each.
+template<class T>
+struct block_reflector
+{
+    std::vector<T>  _v;         // rows x size, unit lower trapezoidal
+    std::vector<T>  _t;         // size x size, upper triangular
+    size_t          _rows = 0;
+    size_t          _size = 0;
+
+    void build(size_t m, const T* a, size_t lda, size_t k, size_t size, const T* tau)
+    {
+        _rows = m - k;
+        _size = size;
+        _v.assign(_rows * size, T(0));
+        _t.assign(size * size, T(0));
+
+        for (size_t p = 0; p < size; ++p) {
+            auto v   = &_v[p * _rows];
+            auto col = a + k + (k + p) * lda;
+            v[p] = T(1);
+            for (auto i = p + 1; i < _rows; ++i) v[i] = col[i];
+        }
+
+        // t(0:i, i) = -tau_i * t(0:i, 0:i) * v(:, 0:i)^T * v_i
+        std::vector<T> z(size);
+        for (size_t i = 0; i < size; ++i) {
+            const auto vi = &_v[i * _rows];
+            for (size_t p = 0; p < i; ++p) {
+                const auto vp = &_v[p * _rows];
+                T dot = 0;
+                for (auto r = i; r < _rows; ++r) dot += vp[r] * vi[r];
+                z[p] = dot;
+            }
+            for (size_t r = 0; r < i; ++r) {
+                T dot = 0;
+                for (auto q = r; q < i; ++q) dot += _t[r + q * size] * z[q];
+                _t[r + i * size] = -tau[k + i] * dot;
+            }
+            _t[i + i * size] = tau[k + i];
+        }
+    }
+
+    // c = h * c, or h^T * c when `trans`; c is rows x n.
+    void apply(bool trans, size_t n, T* c, size_t ldc) const
+    {
+        if (n == 0) return;
+
+        // w = op(t) * v^T * c, one column of c per item.
+        std::vector<T> w(_size * n);
+        parallel_for(n, std::max(size_t(1), gemm_grain / (_rows * _size)), [&](size_t, size_t first, size_t last) {
+            std::vector<T> x(_size);
+            for (auto j = first; j < last; ++j) {
+                const auto cj = c + j * ldc;
+                for (size_t p = 0; p < _size; ++p) {
+                    const auto vp = &_v[p * _rows];
+                    T dot = 0;
+                    for (auto i = p; i < _rows; ++i) dot += vp[i] * cj[i];
+                    x[p] = dot;
+                }
+
+                auto wj = &w[j * _size];
+                for (size_t p = 0; p < _size; ++p) {
+                    T dot = 0;
+                    if (trans) for (size_t q = 0; q <= p; ++q)     dot += _t[q + p * _size] * x[q];
+                    else       for (auto q = p; q < _size; ++q)    dot += _t[p + q * _size] * x[q];
+                    wj[p] = dot;
+                }
+            }
+        });
+
+        // c -= v * w
+        gemm_sub(_rows, n, _size, _v.data(), _rows, w.data(), 1, _size, c, ldc);
+    }
+};
+
+// a = q * r in place (m x n): r on and above the diagonal, the reflectors below it.
+template<class T>
+void qr_inplace(size_t m, size_t n, T* a, size_t lda, T* tau)
+{
+    const auto kmax = std::min(m, n);
+
+    block_reflector<T> h;
+    for (size_t k = 0; k < kmax; k += panel_size) {
+        const auto size = std::min(panel_size, kmax - k);
+        qr_panel(m, a, lda, k, size, tau);
+
+        if (k + size < n) {
+            h.build(m, a, lda, k, size, tau);
+            h.apply(true, n - k - size, a + k + (k + size) * lda, lda);
+        }
+    }
+}
+
+// the first kq columns of q = h_0 * h_1 * ..., accumulated backwards from the identity.
+template<class T>
+void qr_form_q(size_t m, size_t kq, const T* a, size_t lda, const T* tau, T* q, size_t ldq)
+{
+    for (size_t j = 0; j < kq; ++j) {
+        std::fill(q + j * ldq, q + j * ldq + m, T(0));
+        q[j + j * ldq] = T(1);
+    }
+    if (kq == 0) return;
+
+    block_reflector<T> h;
+    for (auto k = (kq - 1) / panel_size * panel_size; ; k -= panel_size) {
+        const auto size = std::min(panel_size, kq - k);
+        h.build(m, a, lda, k, size, tau);
+        h.apply(false, kq - k, q + k + k * ldq, ldq);
+        if (k == 0) break;
+    }
+}
+
+// contiguous copy of `s`, which the factorizations then overwrite.
+template<class T, size_t N>
+ndarray<T, 2> to_matrix(const ndslice<array_view<T>, N>& s)
+{
+    const auto rows = s.shape()[0];
+    const auto cols = lane_count(s, 0);
+
+    ndarray<T, 2> result({ rows, cols });
+    auto out = &result.data()[0];
+
+    const auto stride = s.stride()[0];
+    parallel_for(cols, std::max(size_t(1), gemm_grain / std::max(rows, size_t(1))), [&](size_t, size_t first, size_t last) {
+        for (auto j = first; j < last; ++j) {
+            auto in = &s.data()[lane_offset(s, 0, j)];
+            for (size_t i = 0; i < rows; ++i) out[i + j * rows] = in[i * stride];
+        }
+    });
+    return result;
+}
+
+template<class T>
+T* data_of(const ndarray<T, 2>& a)
+{
+    return &a.data()[0];
+}
+
+// tasks the widest parallel_for of a kernel is split into, for the trace: the update of the
+// first panel, `cols` columns of `rows` rows with `size` folded in. one when it all runs on the
+// calling thread, being small or inside another parallel_for.
+inline size_t update_tasks(size_t rows, size_t cols, size_t size)
+{
+    if (core::detail::in_parallel() || rows == 0 || cols == 0 || size == 0) return 1;
+    return task_count(cols, std::max(size_t(1), gemm_grain / (rows * size)), thread_count());
+}
+
+// update_tasks() of factoring an m x n matrix, k columns in all.
+inline size_t factor_tasks(size_t m, size_t n, size_t k)
+{
+    const auto size = std::min(panel_size, k);
+    return update_tasks(std::max(m - size, size), n - size, size);
+}
+
+// update_tasks() of trsm() on an n x n triangle and nrhs columns.
+inline size_t trsm_tasks(size_t n, size_t nrhs)
+{
+    const auto size = std::min(panel_size, n);
+    return update_tasks(std::max(n - size, size), nrhs, size);
+}
+
+inline void check_square(size_t rows, size_t cols)
+{
+    if (rows != cols) {
+        throw std::invalid_argument("lumpy: matrix must be square");
+    }
+}
+}
+
+#pragma region lu
+template<class T>
+struct lu_factor
+{
+    ndarray<T, 2>       lu;     // unit lower l below the diagonal, u on and above it
+    ndarray<size_t, 1>  perm;   // row i of p * a is row perm(i) of a
+    int                 sign;   // determinant of p
+};
+
+// p * a = l * u, with partial pivoting.
+template<class T, class = static_if<is_float<T>> >
+lu_factor<T> lu(const ndslice<array_view<T>, 2>& a)
+{
+    const auto m = a.shape()[0], n = a.shape()[1];
+
+    lumpy_trace("linalg.lu", trace::split(detail::factor_tasks(m, n, std::min(m, n))), m * n * std::min(m, n), m * n * sizeof(T));
+
+    lu_factor<T> result{ detail::to_matrix(a), ndarray<size_t, 1>({ m }), 1 };
+    detail::lu_inplace(m, n, detail::data_of(result.lu), m, &result.perm.data()[0], result.sign);
+    return result;
+}
+
+// x with a * x = b, from the factors of a.
+template<class T>
+ndarray<T, 2> solve(const lu_factor<T>& f, const ndslice<array_view<T>, 2>& b)
+{
+    const auto n = f.lu.shape()[0], nrhs = b.shape()[1];
+    detail::check_square(n, f.lu.shape()[1]);
+    if (b.shape()[0] != n) {
+        throw std::invalid_argument("lumpy: solve() operands do not match");
+    }
+
+    const auto lu = detail::data_of(f.lu);
+    for (size_t i = 0; i < n; ++i) {
+        if (lu[i + i * n] == T(0)) throw std::domain_error("lumpy: matrix is singular");
+    }
+
+    lumpy_trace("linalg.solve", trace::split(detail::trsm_tasks(n, nrhs)), n * n * nrhs, (n * n + 2 * n * nrhs) * sizeof(T));
+
+    ndarray<T, 2> x({ n, nrhs });
+    const auto out = detail::data_of(x);
+    const auto stride = b.stride()[0];
+    for (size_t j = 0; j < nrhs; ++j) {
+        auto in = &b.data()[j * b.stride()[1]];
+        for (size_t i = 0; i < n; ++i) out[i + j * n] = in[f.perm(i) * stride];
+    }
+
+    detail::trsm(true,  true,  n, nrhs, lu, n, out, n);
+    detail::trsm(false, false, n, nrhs, lu, n, out, n);
+    return x;
+}
+
+template<class T>
+ndarray<T, 1> solve(const lu_factor<T>& f, const ndslice<array_view<T>, 1>& b)
+{
+    const auto x = solve(f, ndslice<array_view<T>, 2>(b.data(), { b.shape()[0], 1 }, { b.stride()[0], b.shape()[0] * b.stride()[0] }));
+    return{ ndslice<array_view<T>, 1>(x.data(), { b.shape()[0] }), x.sdata() };
+}
+
+template<class T, size_t N, class = static_if<is_float<T> && (N == 1 || N == 2)> >
+ndarray<T, N> solve(const ndslice<array_view<T>, 2>& a, const ndslice<array_view<T>, N>& b)
+{
+    detail::check_square(a.shape()[0], a.shape()[1]);
+    return solve(lu(a), b);
+}
+
+template<class T, class = static_if<is_float<T>> >
+ndarray<T, 2> inv(const ndslice<array_view<T>, 2>& a)
+{
+    const auto n = a.shape()[0];
+    detail::check_square(n, a.shape()[1]);
+
+    ndarray<T, 2> identity({ n, n });
+    const auto data = detail::data_of(identity);
+    std::fill(data, data + n * n, T(0));
+    for (size_t i = 0; i < n; ++i) data[i + i * n] = T(1);
+
+    return solve(lu(a), identity);
+}
+
+template<class T, class = static_if<is_float<T>> >
+T det(const ndslice<array_view<T>, 2>& a)
+{
+    const auto n = a.shape()[0];
+    detail::check_square(n, a.shape()[1]);
+
+    const auto f  = lu(a);
+    const auto lu = detail::data_of(f.lu);
+
+    auto value = T(f.sign);
+    for (size_t i = 0; i < n; ++i) value *= lu[i + i * n];
+    return value;
+}
+#pragma endregion
+
+#pragma region cholesky
+// lower triangular l with a = l * l^T; only the lower triangle of `a` is read.
+template<class T, class = static_if<is_float<T>> >
+ndarray<T, 2> cholesky(const ndslice<array_view<T>, 2>& a)
+{
+    const auto n = a.shape()[0];
+    detail::check_square(n, a.shape()[1]);
+
+    lumpy_trace("linalg.cholesky", trace::split(detail::factor_tasks(n, n, n)), n * n * n / 3, n * n * sizeof(T));
+
+    auto l = detail::to_matrix(a);
+    const auto data = detail::data_of(l);
+    detail::cholesky_inplace(n, data, n);
+
+    for (size_t j = 1; j < n; ++j) {
+        std::fill(data + j * n, data + j * n + j, T(0));
+    }
+    return l;
+}
+#pragma endregion
+
+#pragma region qr
+// a = q * r, with q (m x k) orthonormal columns and r (k x n) upper triangular, k = min(m, n).
+template<class T, class = static_if<is_float<T>> >
+std::pair<ndarray<T, 2>, ndarray<T, 2>> qr(const ndslice<array_view<T>, 2>& a)
+{
+    const auto m = a.shape()[0], n = a.shape()[1], k = std::min(m, n);
+
+    lumpy_trace("linalg.qr", trace::split(detail::factor_tasks(m, n, k)), 2 * m * n * k, (m * n + m * k) * sizeof(T));
+
+    auto f = detail::to_matrix(a);
+    std::vector<T> tau(k);
+    detail::qr_inplace(m, n, detail::data_of(f), m, tau.data());
+
+    ndarray<T, 2> q({ m, k });
+    detail::qr_form_q(m, k, detail::data_of(f), m, tau.data(), detail::data_of(q), m);
+
+    ndarray<T, 2> r({ k, n });
+    const auto in = detail::data_of(f), out = detail::data_of(r);
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < k; ++i) out[i + j * k] = i <= j ? in[i + j * m] : T(0);
+    }
+    return{ q, r };
+}
+#pragma endregion
+
+#pragma region triangular
+// x with t * x = b, t lower (or upper) triangular; the other triangle of `t` is not read.
+template<class T, size_t N, class = static_if<is_float<T> && (N == 1 || N == 2)> >
+ndarray<T, N> solve_triangular(const ndslice<array_view<T>, 2>& t, const ndslice<array_view<T>, N>& b, bool lower = true)
+{
+    const auto n = t.shape()[0];
+    detail::check_square(n, t.shape()[1]);
+    if (b.shape()[0] != n) {
+        throw std::invalid_argument("lumpy: solve_triangular() operands do not match");
+    }
+
+    const auto nrhs = lane_count(b, 0);
+    lumpy_trace("linalg.solve_triangular", trace::split(detail::trsm_tasks(n, nrhs)), n * n * nrhs, (n * n + 2 * n * nrhs) * sizeof(T));
+
+    const auto m = detail::to_matrix(t);
+    const auto x = detail::to_matrix(b);
+    detail::trsm(lower, false, n, nrhs, detail::data_of(m), n, detail::data_of(x), n);
+
+    array<size_t, N> shape;
+    for (size_t i = 0; i < N; ++i) shape[i] = b.shape()[i];
+    return{ ndslice<array_view<T>, N>(x.data(), shape._elements), x.sdata() };
+}
+#pragma endregion
+
+}
+
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <stdexcept>
+
+#include <lumpy/core.h>
+#include <lumpy/math/approx.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+// counter-based random numbers: element i of an array is philox4x32-10(counter=i, key=seed),
+// mapped through a distribution. nothing is carried from one element to the next, so filling
+// is split across threads and vectorized freely, and the result only depends on the seed and
+// the element's position, never on the thread count.
+namespace random
+{
+
+using bits_t = array<uint, 4>;
+
+// the full 128-bit counter and 64-bit key, as in the random123 reference.
+inline bits_t philox(const bits_t& counter, const array<uint, 2>& key) noexcept
+{
+    uint c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint k0 = key[0],     k1 = key[1];
+
+    for (auto round = 0; round < 10; ++round) {
+        auto p0 = ullong(0xD2511F53u) * c0;
+        auto p1 = ullong(0xCD9E8D57u) * c2;
+
+        auto n0 = uint(p1 >> 32) ^ c1 ^ k0;
+        auto n2 = uint(p0 >> 32) ^ c3 ^ k1;
+        c1 = uint(p1);
+        c3 = uint(p0);
+        c0 = n0;
+        c2 = n2;
+
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return{ { c0, c1, c2, c3 } };
+}
+
+inline bits_t philox(ullong counter, ullong seed) noexcept
+{
+    return philox(bits_t{ { uint(counter), uint(counter >> 32), 0, 0 } }, array<uint, 2>{ { uint(seed), uint(seed >> 32) } });
+}
+
+#pragma region distributions
+namespace detail
+{
+// [0, 1) from the high bits of one/two words.
+inline float  to_unit(uint a)           noexcept { return float(a >> 8) * 5.9604644775390625e-8f; }
+inline double to_unit(uint a, uint b)   noexcept { return double(((ullong(a) << 32) | b) >> 11) * 1.1102230246251565e-16; }
+}
+
+template<class T>
+struct f_uniform
+{
+    T lo = T(0);
+    T hi = T(1);
+
+    T operator()(const bits_t& bits) const noexcept
+    {
+        return lo + (hi - lo) * T(unit(bits, T{}));
+    }
+
+private:
+    static float  unit(const bits_t& bits, float)  noexcept { return detail::to_unit(bits[0]); }
+    static double unit(const bits_t& bits, double) noexcept { return detail::to_unit(bits[0], bits[1]); }
+};
+
+// box-muller, using the approx kernels so the transform stays vectorizable.
+template<class T>
+struct f_normal
+{
+    T mean   = T(0);
+    T stddev = T(1);
+
+    T operator()(const bits_t& bits) const noexcept
+    {
+        return mean + stddev * T(value(bits, T{}));
+    }
+
+private:
+    static float value(const bits_t& bits, float) noexcept
+    {
+        auto u1 = 1.0f - detail::to_unit(bits[0]);     // (0, 1]
+        auto u2 = detail::to_unit(bits[1]);
+        return approx::sqrt(-2.0f * approx::log(u1)) * approx::cos(6.28318530717958647692f * u2);
+    }
+
+    static double value(const bits_t& bits, double) noexcept
+    {
+        auto u1 = 1.0 - detail::to_unit(bits[0], bits[1]);
+        auto u2 = detail::to_unit(bits[2], bits[3]);
+        return approx::sqrt(-2.0 * approx::log(u1)) * approx::cos(6.28318530717958647692 * u2);
+    }
+};
+
+// [lo, hi) by multiply-shift; the bias is below 2^-64 * (hi - lo).
+template<class T>
+struct f_integers
+{
+    T lo;
+    T hi;
+
+    f_integers(T lo, T hi)
+        : lo(lo), hi(hi)
+    {
+        if (!(lo < hi)) {
+            throw std::invalid_argument("lumpy: integers needs lo < hi");
+        }
+    }
+
+    T operator()(const bits_t& bits) const noexcept
+    {
+        auto range = ullong(hi) - ullong(lo);
+        auto word  = (ullong(bits[0]) << 32) | bits[1];
+
+        // high 64 bits of word * range, without a 128-bit type.
+        auto a = word >> 32, b = word & 0xffffffffu;
+        auto c = range >> 32, d = range & 0xffffffffu;
+        auto mid = (b * d >> 32) + (a * d & 0xffffffffu) + (b * c & 0xffffffffu);
+        auto high = a * c + (a * d >> 32) + (b * c >> 32) + (mid >> 32);
+
+        return T(ullong(lo) + high);
+    }
+};
+
+struct f_bernoulli
+{
+    double p;
+
+    f_bernoulli(double p = 0.5)
+        : p(p)
+    {
+        if (!(p >= 0 && p <= 1)) {
+            throw std::invalid_argument("lumpy: bernoulli p must be in [0, 1]");
+        }
+    }
+
+    bool operator()(const bits_t& bits) const noexcept
+    {
+        return detail::to_unit(bits[0], bits[1]) < p;
+    }
+};
+#pragma endregion
+
+#pragma region view
+// lazy random array, element i is dist(philox(i, seed)). like array_iota it stores no data,
+// so reshape()-ing it gives an ndslice that plugs straight into ndview expressions.
+template<class D>
+struct array_random
+{
+    using type = decltype(declval<D>()(bits_t{}));
+
+    constexpr array_random(D dist, ullong seed, size_t size, size_t first = 0)
+        : _dist(dist), _seed(seed), _first(first), _size(size)
+    {}
+
+    type        operator[](size_t i)    const noexcept { return _dist(philox(_first + i, _seed)); }
+    constexpr size_t size()             const noexcept { return _size; }
+
+    constexpr array_random slice(size_t first, size_t last) const noexcept
+    {
+        return{ _dist, _seed, shrink$(last, _size) - shrink$(first, _size) + 1, _first + shrink$(first, _size) };
+    }
+
+private:
+    D       _dist;
+    ullong  _seed;
+    size_t  _first;
+    size_t  _size;
+};
+
+template<class D, size_t N>
+auto view(const size_t(&shape)[N], ullong seed, D dist)
+{
+    return ndslice<array_random<D>, N>(array_random<D>(dist, seed, product_array(shape)), shape);
+}
+#pragma endregion
+
+#pragma region fill
+constexpr size_t fill_grain = 1 << 14;
+
+// element (i0, i1, ...) of `s` gets dist(philox(i0 + i1*n0 + ..., seed)).
+template<class T, size_t N, class D>
+void fill(const ndslice<array_view<T>, N>& s, ullong seed, D dist)
+{
+    const auto stride = s.stride()[0];
+
+    lumpy_trace("random.fill", trace::split(task_count(s.size(), fill_grain, thread_count())), s.size(), s.size() * sizeof(T));
+
+    parallel_for(s.size(), fill_grain, [&](size_t, size_t first, size_t last) {
+        for_each_run(s, first, last, [&](size_t offset, size_t index, size_t count) {
+            auto out = &s.data()[offset];
+            for (size_t i = 0; i < count; ++i) {
+                out[i * stride] = T(dist(philox(index + i, seed)));
+            }
+        });
+    });
+}
+
+template<class T = double, size_t N>
+ndarray<T, N> uniform(const size_t(&shape)[N], ullong seed, T lo = T(0), T hi = T(1))
+{
+    ndarray<T, N> result(shape);
+    fill(result, seed, f_uniform<T>{ lo, hi });
+    return result;
+}
+
+template<class T = double, size_t N>
+ndarray<T, N> normal(const size_t(&shape)[N], ullong seed, T mean = T(0), T stddev = T(1))
+{
+    ndarray<T, N> result(shape);
+    fill(result, seed, f_normal<T>{ mean, stddev });
+    return result;
+}
+
+template<class T = llong, size_t N>
+ndarray<T, N> integers(const size_t(&shape)[N], ullong seed, T lo, T hi)
+{
+    ndarray<T, N> result(shape);
+    fill(result, seed, f_integers<T>{ lo, hi });
+    return result;
+}
+
+template<size_t N>
+ndarray<bool, N> bernoulli(const size_t(&shape)[N], ullong seed, double p = 0.5)
+{
+    ndarray<bool, N> result(shape);
+    fill(result, seed, f_bernoulli{ p });
+    return result;
+}
+#pragma endregion
+
+}
+
+}
+
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+// statistics over every window of `window` consecutive elements along an axis. the result has
+// the shape of the input with that axis shrunk to n - window + 1, the same shape as
+// sliding_window(s, window, axis) without its last axis.
+//
+// each kernel slides a running state (a compensated sum, a mean/m2 pair, a monotonic deque)
+// one element at a time, so a lane costs O(n) whatever the window. long lanes are cut into
+// chunks that each restart the state, so the 1-d case still spreads over threads.
+namespace detail
+{
+constexpr size_t rolling_grain = 1 << 15;   // windows per task
+
+// accumulator of sums and means: compensated double for floats, 64-bit integers (exact) otherwise.
+template<class T> using sum_t  = std::conditional_t<is_float<T>, double, std::conditional_t<std::is_signed<T>::value, llong, ullong>>;
+template<class T> using mean_t = std::conditional_t<is_same<T, float>, float, double>;
+
+template<class T>
+struct rolling_sum
+{
+    using type = std::conditional_t<is_float<T>, T, sum_t<T>>;
+
+    // neumaier compensation on the added and removed values.
+    static void add(double& sum, double& low, double value)
+    {
+        auto next = sum + value;
+        low += (sum >= value) == (sum >= -value) ? (sum - next) + value : (value - next) + sum;
+        sum  = next;
+    }
+
+    template<class U> static void add(U& sum, U&, U value) { sum += value; }
+
+    void operator()(const T* in, size_t stride, type* out, size_t ostride, size_t window, size_t first, size_t last) const
+    {
+        sum_t<T> sum = 0, low = 0;
+        for (size_t i = first; i < first + window; ++i) add(sum, low, sum_t<T>(in[i * stride]));
+
+        out[first * ostride] = type(sum + low);
+        for (size_t i = first + 1; i < last; ++i) {
+            add(sum, low, sum_t<T>(in[(i + window - 1) * stride]));
+            add(sum, low, -sum_t<T>(in[(i - 1) * stride]));
+            out[i * ostride] = type(sum + low);
+        }
+    }
+};
+
+template<class T>
+struct rolling_mean
+{
+    using type = mean_t<T>;
+
+    void operator()(const T* in, size_t stride, type* out, size_t ostride, size_t window, size_t first, size_t last) const
+    {
+        sum_t<T> sum = 0, low = 0;
+        for (size_t i = first; i < first + window; ++i) rolling_sum<T>::add(sum, low, sum_t<T>(in[i * stride]));
+
+        const auto scale = 1.0 / double(window);
+        out[first * ostride] = type(double(sum + low) * scale);
+        for (size_t i = first + 1; i < last; ++i) {
+            rolling_sum<T>::add(sum, low, sum_t<T>(in[(i + window - 1) * stride]));
+            rolling_sum<T>::add(sum, low, -sum_t<T>(in[(i - 1) * stride]));
+            out[i * ostride] = type(double(sum + low) * scale);
+        }
+    }
+};
+
+// welford, with the oldest value swapped for the newest in one update.
+template<class T>
+struct rolling_var
+{
+    using type = mean_t<T>;
+
+    size_t ddof = 0;
+
+    void operator()(const T* in, size_t stride, type* out, size_t ostride, size_t window, size_t first, size_t last) const
+    {
+        double mean = 0, m2 = 0;
+        for (size_t i = first; i < first + window; ++i) {
+            auto value = double(in[i * stride]);
+            auto delta = value - mean;
+            mean += delta / double(i - first + 1);
+            m2   += delta * (value - mean);
+        }
+
+        const auto scale = 1.0 / double(window - ddof);
+        out[first * ostride] = type(m2 * scale);
+        for (size_t i = first + 1; i < last; ++i) {
+            auto value = double(in[(i + window - 1) * stride]);
+            auto old   = double(in[(i - 1) * stride]);
+            auto delta = value - old;
+            auto next  = mean + delta / double(window);
+            m2  += delta * (value - next + old - mean);
+            m2   = m2 < 0 ? 0 : m2;
+            mean = next;
+            out[i * ostride] = type(m2 * scale);
+        }
+    }
+};
+
+// monotonic deque of indexs in a ring of `window` slots: values increase (min) or
+// decrease (max) from front to back, so the front is the extreme of the current window.
+template<class T, bool Max>
+struct rolling_extreme
+{
+    using type = T;
+
+    void operator()(const T* in, size_t stride, type* out, size_t ostride, size_t window, size_t first, size_t last) const
+    {
+        std::vector<size_t> ring(window);
+        size_t head = 0, count = 0;
+
+        auto before = [](const T& a, const T& b) { return Max ? !(a < b) : !(b < a); };
+
+        for (auto i = first; i < last + window - 1; ++i) {
+            // drop the index leaving the window before pushing, so the ring never overflows.
+            if (count != 0 && ring[head] + window <= i) {
+                head = (head + 1) % window;
+                --count;
+            }
+
+            const auto value = in[i * stride];
+            while (count != 0 && !before(in[ring[(head + count - 1) % window] * stride], value)) --count;
+            ring[(head + count++) % window] = i;
+
+            if (i + 1 >= first + window) {
+                out[(i + 1 - window) * ostride] = in[ring[head] * stride];
+            }
+        }
+    }
+};
+
+// run `kernel` over every lane of `s` along `axis`, cut into chunks of windows.
+template<class T, size_t N, class K>
+ndarray<typename K::type, N> rolling(const char* name, const ndslice<array_view<T>, N>& s, size_t window, size_t axis, K kernel)
+{
+    using R = typename K::type;
+    (void)name;     // only traced in profile builds
+
+    if (axis >= N) {
+        throw std::invalid_argument("lumpy: rolling axis out of range");
+    }
+    if (window == 0 || window > s.shape()[axis]) {
+        throw std::invalid_argument("lumpy: rolling window must be 1..n");
+    }
+
+    auto shape = s.shape();
+    shape[axis] = shape[axis] - window + 1;
+
+    ndarray<R, N> result(shape._elements);
+
+    const auto windows = shape[axis];
+    const auto lanes   = lane_count(result, axis);
+    // every chunk refills its window first, so chunks are kept at least a window long.
+    const auto length  = std::max(rolling_grain, window);
+    const auto chunks  = windows < length ? 1 : windows / length;
+    const auto grain   = windows >= rolling_grain ? 1 : rolling_grain / windows;
+
+    const auto stride  = s.stride()[axis];
+    const auto ostride = result.stride()[axis];
+
+    lumpy_trace(name, trace::split(task_count(lanes * chunks, grain, thread_count())), result.size(), s.size() * sizeof(T) + result.size() * sizeof(R));
+
+    parallel_for(lanes * chunks, grain, [&](size_t, size_t a, size_t b) {
+        for (auto task = a; task < b; ++task) {
+            const auto lane  = task / chunks;
+            const auto chunk = task % chunks;
+
+            auto in  = &s.data()[lane_offset(s, axis, lane)];
+            auto out = &result.data()[lane_offset(result, axis, lane)];
+            kernel(in, stride, out, ostride, window, windows * chunk / chunks, windows * (chunk + 1) / chunks);
+        }
+    });
+    return result;
+}
+}
+
+#pragma region rolling
+// sum of each window; integers are summed in 64 bits. window must be in 1..n.
+template<class T, size_t N>
+auto rolling_sum(const ndslice<array_view<T>, N>& s, size_t window, size_t axis = 0)
+{
+    return detail::rolling("rolling.sum", s, window, axis, detail::rolling_sum<T>{});
+}
+
+template<class T, size_t N>
+auto rolling_mean(const ndslice<array_view<T>, N>& s, size_t window, size_t axis = 0)
+{
+    return detail::rolling("rolling.mean", s, window, axis, detail::rolling_mean<T>{});
+}
+
+// variance of each window, divided by window - ddof.
+template<class T, size_t N>
+auto rolling_var(const ndslice<array_view<T>, N>& s, size_t window, size_t axis = 0, size_t ddof = 0)
+{
+    if (ddof >= window) {
+        throw std::invalid_argument("lumpy: rolling_var needs ddof < window");
+    }
+    return detail::rolling("rolling.var", s, window, axis, detail::rolling_var<T>{ ddof });
+}
+
+template<class T, size_t N>
+auto rolling_min(const ndslice<array_view<T>, N>& s, size_t window, size_t axis = 0)
+{
+    return detail::rolling("rolling.min", s, window, axis, detail::rolling_extreme<T, false>{});
+}
+
+template<class T, size_t N>
+auto rolling_max(const ndslice<array_view<T>, N>& s, size_t window, size_t axis = 0)
+{
+    return detail::rolling("rolling.max", s, window, axis, detail::rolling_extreme<T, true>{});
+}
+#pragma endregion
+
+}
+
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+#include <lumpy/math/dynamic.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+#pragma region shared_array
+namespace detail
+{
+constexpr ullong shared_magic = 0x6d687379706d756cull;   // "lumpyshm"
+
+// first bytes of the segment; the elements follow at `offset`.
+struct shared_header
+{
+    std::atomic<ullong>     magic;      // stored last, see create()
+    std::atomic<ullong>     version;    // odd while a writer is publishing
+    ullong                  offset;
+    ullong                  bytes;      // of the elements
+    uint                    type;
+    uint                    rank;
+    ullong                  shape[dyn_array::max_rank];
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "lumpy: shared_array needs a lock-free 64-bit atomic");
+
+constexpr size_t shared_offset = (sizeof(shared_header) + 63) / 64 * 64;
+
+inline string shared_name(const string& name)
+{
+    return !name.empty() && name[0] == '/' ? name : "/" + name;
+}
+
+// the header describes aligned elements that fit in the `size` bytes of the segment, so shape()
+// and as<T, N>() can trust it.
+inline bool shared_valid(const shared_header& header, size_t size)
+{
+    if (header.rank == 0 || header.rank > dyn_array::max_rank || header.type >= dtypes::size) return false;
+    if (header.offset < sizeof(shared_header) || header.offset > size) return false;
+    if (header.offset % dtype_align(dtype(header.type)) != 0) return false;
+
+    ullong count = 1;
+    for (size_t i = 0; i < header.rank; ++i) {
+        if (header.shape[i] != 0 && count > ~0ull / header.shape[i]) return false;
+        count *= header.shape[i];
+    }
+    const auto element = dtype_size(dtype(header.type));
+    return count <= ~0ull / element && header.bytes == count * element && header.bytes <= size - header.offset;
+}
+
+[[noreturn]] inline void shared_error(int error, const char* call, const string& name)
+{
+    throw std::system_error(error, std::generic_category(), string("lumpy: ") + call + " '" + name + "'");
+}
+}
+
+// an array in a named posix shared memory segment (shm_open + mmap). one process create()s
+// it, the others open() it by name and see the same elements with no copy; the mapping is
+// released when the last shared_array or array view of it goes away.
+//
+// the header carries dtype, shape and a version counter. a writer that republishes wraps
+// the update in begin_write()/publish(); a reader keeps the version() it started from and
+// asks unchanged(version) afterwards to know whether what it read is still current.
+//
+// a segment open()ed read-only is mapped read-only, so it only gives out const views:
+// as<const T, N>(). array() and as<T, N>() throw for it.
+class shared_array
+{
+public:
+    static shared_array create(const string& name, dtype type, const std::vector<size_t>& shape)
+    {
+        if (shape.empty() || shape.size() > dyn_array::max_rank) {
+            throw std::invalid_argument("lumpy: shared_array rank must be 1.." + std::to_string(dyn_array::max_rank));
+        }
+
+        // the whole segment must fit in a size_t and an off_t.
+        const auto limit = std::min(size_t(std::numeric_limits<off_t>::max()), std::numeric_limits<size_t>::max()) - detail::shared_offset;
+        size_t count = 1;
+        for (auto n : shape) {
+            if (n != 0 && count > limit / n) throw std::invalid_argument("lumpy: shared_array is too large");
+            count *= n;
+        }
+        if (count > limit / dtype_size(type)) throw std::invalid_argument("lumpy: shared_array is too large");
+        const auto bytes = count * dtype_size(type);
+
+        // an existing segment is unlinked rather than truncated, so processes mapping it keep
+        // their elements and only later open()s see the new one.
+        const auto path = detail::shared_name(name);
+        ::shm_unlink(path.c_str());
+
+        const auto fd = ::shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) detail::shared_error(errno, "shm_open", path);
+
+        if (::ftruncate(fd, off_t(detail::shared_offset + bytes)) != 0) {
+            const auto error = errno;
+            ::close(fd);
+            detail::shared_error(error, "ftruncate", path);
+        }
+
+        shared_array result(fd, detail::shared_offset + bytes, true, path);
+
+        auto header = result._header.get();
+        header->offset = detail::shared_offset;
+        header->bytes  = bytes;
+        header->type   = uint(type);
+        header->rank   = uint(shape.size());
+        for (size_t i = 0; i < shape.size(); ++i) header->shape[i] = shape[i];
+        header->version.store(0, std::memory_order_relaxed);
+
+        // published by the magic: a reader that loads it (acquire) sees the whole header.
+        header->magic.store(detail::shared_magic, std::memory_order_release);
+        return result;
+    }
+
+    template<class T, size_t N>
+    static shared_array create(const string& name, const size_t(&shape)[N])
+    {
+        return create(name, dtype_of<T>(), std::vector<size_t>(shape, shape + N));
+    }
+
+    static shared_array open(const string& name, bool writable = false)
+    {
+        const auto path = detail::shared_name(name);
+        const auto fd   = ::shm_open(path.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+        if (fd < 0) detail::shared_error(errno, "shm_open", path);
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            const auto error = errno;
+            ::close(fd);
+            detail::shared_error(error, "fstat", path);
+        }
+        if (size_t(info.st_size) < detail::shared_offset) {
+            ::close(fd);
+            throw std::invalid_argument("lumpy: '" + path + "' is not a shared_array");
+        }
+
+        shared_array result(fd, size_t(info.st_size), writable, path);
+
+        auto header = result._header.get();
+        if (header->magic.load(std::memory_order_acquire) != detail::shared_magic || !detail::shared_valid(*header, size_t(info.st_size))) {
+            throw std::invalid_argument("lumpy: '" + path + "' is not a shared_array");
+        }
+        return result;
+    }
+
+    // remove the name; processes that have it open keep their mapping.
+    static void remove(const string& name)
+    {
+        const auto path = detail::shared_name(name);
+        if (::shm_unlink(path.c_str()) != 0 && errno != ENOENT) detail::shared_error(errno, "shm_unlink", path);
+    }
+
+public:
+    dtype   type()  const noexcept { return dtype(_header->type); }
+    size_t  rank()  const noexcept { return _header->rank; }
+
+    std::vector<size_t> shape() const
+    {
+        return std::vector<size_t>(_header->shape, _header->shape + _header->rank);
+    }
+
+    bool    writable() const noexcept { return _writable; }
+
+    // the elements, sharing the mapping.
+    dyn_array array() const
+    {
+        check_writable();
+        return{ type(), shape(), elements() };
+    }
+
+    template<class T, size_t N>
+    ndarray<T, N> as() const
+    {
+        if (!std::is_const<T>::value) check_writable();
+        return dyn_array(type(), shape(), elements()).as_array<T, N>();
+    }
+
+public:
+    ullong version() const noexcept
+    {
+        return _header->version.load(std::memory_order_acquire);
+    }
+
+    // true when nothing was published since `version` was read, and no write was under way then.
+    bool unchanged(ullong version) const noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version % 2 == 0 && _header->version.load(std::memory_order_relaxed) == version;
+    }
+
+    void begin_write() noexcept
+    {
+        _header->version.fetch_add(1, std::memory_order_acq_rel);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void publish() noexcept
+    {
+        _header->version.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    std::shared_ptr<detail::shared_header> _header;     // the whole mapping
+    bool                                   _writable;
+
+    shared_array(int fd, size_t bytes, bool writable, const string& path)
+        : _writable(writable)
+    {
+        auto address = ::mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        const auto error = errno;
+        ::close(fd);
+        if (address == MAP_FAILED) detail::shared_error(error, "mmap", path);
+
+        _header = std::shared_ptr<detail::shared_header>(static_cast<detail::shared_header*>(address), [bytes](detail::shared_header* header) {
+            ::munmap(header, bytes);
+        });
+    }
+
+    std::shared_ptr<void> elements() const
+    {
+        return{ _header, reinterpret_cast<ubyte*>(_header.get()) + _header->offset };
+    }
+
+    void check_writable() const
+    {
+        if (!_writable) {
+            throw std::invalid_argument("lumpy: shared_array was opened read-only, use as<const T, N>()");
+        }
+    }
+};
+#pragma endregion
+
+}
+
+}
+
+#endif
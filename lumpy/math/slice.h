@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdexcept>
+
 #include <lumpy/core/type.h>
 #include <lumpy/core/array.h>
 
@@ -42,8 +44,10 @@ public:
     {}
 
 public:
+    constexpr auto& data()                const { return _data; }
     constexpr auto& shape()               const { return _shape; }
     constexpr auto& stride()              const { return _stride; }
+    constexpr auto  size()                const { return product_array(_shape._elements); }
 
     template<size_t ..._Ns, class = static_if<sizeof...(_Ns) == N && if_all((_Ns <= 2)...) > >
     constexpr auto slice(const size_t(&...sections)[_Ns]) const
@@ -100,6 +104,22 @@ struct _IsExpr;
 template<class T, size_t N>
 struct _IsExpr<ndslice<T, N>> : true_type{};
 
+template<class E, class>
+struct _SameExpr;
+
+template<class T, size_t N>
+struct _SameExpr<ndslice<array_view<T>, N>>
+{
+    static constexpr bool run(const ndslice<array_view<T>, N>& a, const ndslice<array_view<T>, N>& b)
+    {
+        if (a.data()._elements != b.data()._elements) return false;
+        for (size_t i = 0; i < N; ++i) {
+            if (a.shape()[i] != b.shape()[i] || a.stride()[i] != b.stride()[i]) return false;
+        }
+        return true;
+    }
+};
+
 
 template<class _T, size_t... _Ns>
 auto slice(_T& value, const size_t(&...sections)[_Ns])
@@ -107,6 +127,73 @@ auto slice(_T& value, const size_t(&...sections)[_Ns])
     return value.slice(sections...);
 }
 
+#pragma region lanes
+// a lane is the 1-d run of elements along one axis, with every other index fixed. an axis of
+// length 0 still has the lanes of the other axes, all empty.
+template<class T, size_t N>
+constexpr size_t lane_count(const ndslice<T, N>& s, size_t axis)
+{
+    size_t count = 1;
+    for (size_t i = 0; i < N; ++i) {
+        if (i != axis) count *= s.shape()[i];
+    }
+    return count;
+}
+
+// offset into data() of the first element of lane `index` along `axis`.
+template<class T, size_t N>
+constexpr size_t lane_offset(const ndslice<T, N>& s, size_t axis, size_t index)
+{
+    size_t offset = 0;
+    for (size_t i = 0; i < N; ++i) {
+        if (i == axis) continue;
+        offset += (index % s.shape()[i]) * s.stride()[i];
+        index  /= s.shape()[i];
+    }
+    return offset;
+}
+
+// call func(offset, index, count) for the runs along axis 0 that cover the logical elements
+// [first, last), where index is the logical position (i0 + i1*n0 + ...) of the run's first element.
+template<class T, size_t N, class F>
+void for_each_run(const ndslice<T, N>& s, size_t first, size_t last, F&& func)
+{
+    const auto length = s.shape()[0];
+    for (auto index = first; index < last; ) {
+        auto lane   = index / length;
+        auto column = index % length;
+        auto count  = length - column < last - index ? length - column : last - index;
+
+        func(lane_offset(s, 0, lane) + column * s.stride()[0], index, count);
+        index += count;
+    }
+}
+#pragma endregion
+
+#pragma region sliding_window
+// zero-copy windows of length `window` (1..n) along `axis`: that axis shrinks to n - window + 1
+// and a new last axis walks the window, reusing the stride of `axis`.
+template<class T, size_t N>
+ndslice<T, N + 1> sliding_window(const ndslice<T, N>& s, size_t window, size_t axis = 0)
+{
+    if (axis >= N || window == 0 || window > s.shape()[axis]) {
+        throw std::invalid_argument("lumpy: sliding_window needs window in 1..n along an existing axis");
+    }
+
+    size_t shape[N + 1];
+    size_t stride[N + 1];
+    for (size_t i = 0; i < N; ++i) {
+        shape[i]  = s.shape()[i];
+        stride[i] = s.stride()[i];
+    }
+    shape[axis]  = s.shape()[axis] - window + 1;
+    shape[N]     = window;
+    stride[N]    = s.stride()[axis];
+
+    return{ s.data(), shape, stride };
+}
+#pragma endregion
+
 #pragma region reshape
 
 template<class T, size_t S>
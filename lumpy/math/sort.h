@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/core.h>
+#include <lumpy/math/slice.h>
+#include <lumpy/math/array.h>
+
+namespace lumpy
+{
+
+namespace math
+{
+
+// ordering along one axis of a slice. axis 0 is the contiguous one (stride 1) in lumpy's
+// layout; other axes are gathered lane by lane into a per-thread buffer, so no transposed
+// copy of the whole slice is ever made.
+//
+// lanes are spread over threads; a single large lane (the 1-d case) is sorted by a
+// parallel merge sort, and its top-k by per-thread heaps merged at the end.
+namespace detail
+{
+constexpr size_t sort_grain  = 1 << 15;     // elements per task
+constexpr size_t merge_grain = 1 << 16;     // below this a 1-d input is sorted inline
+
+// scratch space for one strided lane (std::vector<bool> has no data()).
+template<class T>
+struct lane_buffer
+{
+    std::unique_ptr<T[]>    _elements;
+    size_t                  _size = 0;
+
+    T* get(size_t count)
+    {
+        if (count > _size) {
+            lumpy_trace_alloc(count * sizeof(T));
+            _elements.reset(new T[count]);
+            _size = count;
+        }
+        return _elements.get();
+    }
+};
+
+// call func(first, count) for the lane, copying strided lanes through `buffer`.
+template<class T, class F>
+void with_lane(T* data, size_t stride, size_t count, lane_buffer<T>& buffer, bool write_back, F&& func)
+{
+    if (stride == 1) {
+        func(data, count);
+        return;
+    }
+
+    auto temp = buffer.get(count);
+    for (size_t i = 0; i < count; ++i) temp[i] = data[i * stride];
+    func(temp, count);
+    if (write_back) {
+        for (size_t i = 0; i < count; ++i) data[i * stride] = temp[i];
+    }
+}
+
+template<class T, size_t N>
+size_t lane_grain(const ndslice<T, N>& s, size_t axis)
+{
+    const auto length = s.shape()[axis];
+    return length >= sort_grain ? 1 : sort_grain / std::max(length, size_t(1));
+}
+
+// tasks the kernels below split `s` into, for the trace.
+template<class T, size_t N>
+size_t sort_tasks(const ndslice<T, N>& s, size_t axis)
+{
+    const auto lanes = lane_count(s, axis);
+    return lanes == 1
+        ? task_count(s.shape()[axis], merge_grain, thread_count())
+        : task_count(lanes, lane_grain(s, axis), thread_count());
+}
+
+// run func(lane, offset) over every lane of `s` along `axis`, in parallel.
+template<class T, size_t N, class F>
+void for_each_lane(const ndslice<array_view<T>, N>& s, size_t axis, F&& func)
+{
+    parallel_for(lane_count(s, axis), lane_grain(s, axis), [&](size_t, size_t first, size_t last) {
+        for (auto lane = first; lane < last; ++lane) {
+            func(lane, lane_offset(s, axis, lane));
+        }
+    });
+}
+
+template<class T, class Compare>
+void parallel_sort(T* first, size_t count, Compare comp)
+{
+    const auto tasks = task_count(count, merge_grain, thread_count());
+    if (tasks <= 1) {
+        std::sort(first, first + count, comp);
+        return;
+    }
+
+    // sort runs independently, then merge pairs of neighbouring runs until one is left.
+    std::vector<size_t> bounds(tasks + 1);
+    for (size_t i = 0; i <= tasks; ++i) bounds[i] = count * i / tasks;
+
+    parallel_for(tasks, 1, [&](size_t, size_t a, size_t b) {
+        for (auto i = a; i < b; ++i) std::sort(first + bounds[i], first + bounds[i + 1], comp);
+    });
+
+    for (size_t width = 1; width < tasks; width *= 2) {
+        const auto pairs = (tasks + 2 * width - 1) / (2 * width);
+        parallel_for(pairs, 1, [&](size_t, size_t a, size_t b) {
+            for (auto i = a; i < b; ++i) {
+                auto lo  = bounds[std::min(tasks, 2 * i * width)];
+                auto mid = bounds[std::min(tasks, 2 * i * width + width)];
+                auto hi  = bounds[std::min(tasks, 2 * i * width + 2 * width)];
+                std::inplace_merge(first + lo, first + mid, first + hi, comp);
+            }
+        });
+    }
+}
+
+// k largest of [first, first+count) as (value, index) pairs, best first.
+template<class T>
+void topk_lane(const T* first, size_t stride, size_t count, size_t k, std::vector<std::pair<T, size_t>>& heap)
+{
+    // min-heap on value; ties keep the lower index.
+    auto worse = [](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+
+    heap.clear();
+    for (size_t i = 0; i < count; ++i) {
+        auto value = first[i * stride];
+        if (heap.size() < k) {
+            heap.emplace_back(value, i);
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+        else if (value > heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end(), worse);
+            heap.back() = { value, i };
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), worse);
+}
+
+template<size_t N>
+void check_axis(size_t axis)
+{
+    if (axis >= N) {
+        throw std::invalid_argument("lumpy: sort axis out of range");
+    }
+}
+
+template<size_t N>
+auto with_axis(const array<size_t, N>& shape, size_t axis, size_t length)
+{
+    auto result = shape;
+    result[axis] = length;
+    return result;
+}
+}
+
+#pragma region sort
+template<class T, size_t N, class Compare = std::less<>>
+void sort(const ndslice<array_view<T>, N>& s, size_t axis = 0, Compare comp = {})
+{
+    detail::check_axis<N>(axis);
+
+    const auto length = s.shape()[axis];
+    const auto stride = s.stride()[axis];
+
+    lumpy_trace("sort", trace::split(detail::sort_tasks(s, axis)), s.size(), 2 * s.size() * sizeof(T));
+
+    if (s.size() == 0) return;
+    if (lane_count(s, axis) == 1) {
+        detail::lane_buffer<T> buffer;
+        detail::with_lane(&s.data()[0], stride, length, buffer, true, [&](T* first, size_t count) {
+            detail::parallel_sort(first, count, comp);
+        });
+        return;
+    }
+
+    detail::for_each_lane(s, axis, [&](size_t, size_t offset) {
+        thread_local detail::lane_buffer<T> buffer;
+        detail::with_lane(&s.data()[offset], stride, length, buffer, true, [&](T* first, size_t count) {
+            std::sort(first, first + count, comp);
+        });
+    });
+}
+
+template<class T, size_t N, class Compare = std::less<>>
+ndarray<size_t, N> argsort(const ndslice<array_view<T>, N>& s, size_t axis = 0, Compare comp = {})
+{
+    detail::check_axis<N>(axis);
+
+    lumpy_trace("argsort", trace::split(detail::sort_tasks(s, axis)), s.size(), s.size() * (sizeof(T) + sizeof(size_t)));
+
+    ndarray<size_t, N> result(s.shape());
+    if (s.size() == 0) return result;
+
+    const auto length = s.shape()[axis];
+    const auto stride = s.stride()[axis];
+    const auto rstride = result.stride()[axis];
+
+    detail::for_each_lane(s, axis, [&](size_t lane, size_t offset) {
+        thread_local detail::lane_buffer<T> buffer;
+        thread_local std::vector<size_t> indexs;
+
+        indexs.resize(length);
+        std::iota(indexs.begin(), indexs.end(), size_t(0));
+
+        detail::with_lane(&s.data()[offset], stride, length, buffer, false, [&](T* values, size_t) {
+            std::sort(indexs.begin(), indexs.end(), [&](size_t a, size_t b) {
+                return comp(values[a], values[b]) || (!comp(values[b], values[a]) && a < b);
+            });
+        });
+
+        auto out = &result.data()[lane_offset(result, axis, lane)];
+        for (size_t i = 0; i < length; ++i) out[i * rstride] = indexs[i];
+    });
+
+    return result;
+}
+#pragma endregion
+
+#pragma region partition
+// reorder every lane so that element kth is the one a full sort would put there,
+// with nothing greater before it and nothing less after it. kth may count from the end ($).
+template<class T, size_t N, class Compare = std::less<>>
+void partition(const ndslice<array_view<T>, N>& s, size_t kth, size_t axis = 0, Compare comp = {})
+{
+    detail::check_axis<N>(axis);
+
+    const auto length = s.shape()[axis];
+    const auto stride = s.stride()[axis];
+
+    kth = shrink$(kth, length);
+    if (kth >= length) {
+        throw std::invalid_argument("lumpy: partition kth out of range");
+    }
+    if (s.size() == 0) return;
+
+    lumpy_trace("partition", trace::split(detail::sort_tasks(s, axis)), s.size(), 2 * s.size() * sizeof(T));
+
+    detail::for_each_lane(s, axis, [&](size_t, size_t offset) {
+        thread_local detail::lane_buffer<T> buffer;
+        detail::with_lane(&s.data()[offset], stride, length, buffer, true, [&](T* first, size_t count) {
+            std::nth_element(first, first + kth, first + count, comp);
+        });
+    });
+}
+
+template<class T, size_t N, class Compare = std::less<>>
+void nth_element(const ndslice<array_view<T>, N>& s, size_t kth, size_t axis = 0, Compare comp = {})
+{
+    partition(s, kth, axis, comp);
+}
+#pragma endregion
+
+#pragma region topk
+// k largest values along `axis` and their indexs, largest first.
+template<class T, size_t N>
+std::pair<ndarray<T, N>, ndarray<size_t, N>> topk(const ndslice<array_view<T>, N>& s, size_t k, size_t axis = 0)
+{
+    detail::check_axis<N>(axis);
+
+    const auto length = s.shape()[axis];
+    const auto stride = s.stride()[axis];
+    k = std::min(k, length);
+
+    lumpy_trace("topk", trace::split(detail::sort_tasks(s, axis)), s.size(), s.size() * sizeof(T));
+
+    const auto shape = detail::with_axis(s.shape(), axis, k);
+    ndarray<T, N>       values(shape);
+    ndarray<size_t, N>  indexs(shape);
+    if (values.size() == 0) return{ values, indexs };
+
+    auto store = [&](size_t lane, const std::vector<std::pair<T, size_t>>& best) {
+        auto v = &values.data()[lane_offset(values, axis, lane)];
+        auto i = &indexs.data()[lane_offset(indexs, axis, lane)];
+        for (size_t j = 0; j < k; ++j) {
+            v[j * values.stride()[axis]] = best[j].first;
+            i[j * indexs.stride()[axis]] = best[j].second;
+        }
+    };
+
+    if (lane_count(s, axis) == 1 && length > detail::merge_grain) {
+        // 1-d: every thread keeps the top k of its chunk, then the candidates are merged.
+        const auto first = &s.data()[0];
+        std::vector<std::vector<std::pair<T, size_t>>> heaps(thread_count());
+
+        parallel_for(length, detail::merge_grain, [&](size_t task, size_t a, size_t b) {
+            detail::topk_lane(first + a * stride, stride, b - a, k, heaps[task]);
+            for (auto& item : heaps[task]) item.second += a;
+        });
+
+        std::vector<std::pair<T, size_t>> best;
+        for (auto& heap : heaps) best.insert(best.end(), heap.begin(), heap.end());
+        std::sort(best.begin(), best.end(), [](const std::pair<T, size_t>& a, const std::pair<T, size_t>& b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+        store(0, best);
+        return{ values, indexs };
+    }
+
+    detail::for_each_lane(s, axis, [&](size_t lane, size_t offset) {
+        thread_local std::vector<std::pair<T, size_t>> heap;
+        detail::topk_lane(&s.data()[offset], stride, length, k, heap);
+        store(lane, heap);
+    });
+
+    return{ values, indexs };
+}
+#pragma endregion
+
+}
+
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cmath>
+#include <tuple>
+
+#include <lumpy/math/approx.h>
+
 namespace lumpy
 {
 namespace math
@@ -8,6 +13,9 @@ namespace math
 template<class T, size_t>
 struct ndslice;
 
+template<class T, size_t>
+class ndarray;
+
 template<class F, class ...Ts>
 struct ndview;
 
@@ -36,6 +44,43 @@ struct ndview<F, A, B>
     }
 };
 
+template<class F, class A, class B, class C>
+struct ndview<F, A, B, C>
+{
+    A a;
+    B b;
+    C c;
+
+    template<class..._Is>
+    constexpr auto operator()(_Is&& ...is) const
+    {
+        return F::run(a(is...), b(is...), c(is...));
+    }
+};
+
+template<class T>
+struct ndscalar
+{
+    T value;
+
+    template<class..._Is>
+    constexpr auto operator()(_Is&& ...) const
+    {
+        return value;
+    }
+};
+
+// a compile time constant, see constant<V>; simplify() folds x + 0, x * 1, ... away.
+template<int V>
+struct ndconst
+{
+    template<class..._Is>
+    constexpr int operator()(_Is&& ...) const
+    {
+        return V;
+    }
+};
+
 
 #pragma region expressions
 template<class T, class=void>
@@ -47,12 +92,27 @@ constexpr bool is_expr = _IsExpr<T>::value;
 template<class F, class... Ts>
 struct _IsExpr<ndview<F, Ts...>>: true_type{};
 
+template<class T>
+struct _IsExpr<ndscalar<T>>: true_type{};
+
+template<int V>
+struct _IsExpr<ndconst<V>>: true_type{};
+
+template<int V>
+constexpr ndconst<V> constant = {};
+
+template<class T, class=static_if<is_expr<T>> >
+constexpr auto& to_expr(const T& value) { return value; }
+
+template<class T, class=static_if<std::is_arithmetic<T>::value> >
+constexpr auto  to_expr(T value) { return ndscalar<T>{ value }; }
+
 #pragma region operators
-struct f_add { template<class A, class B> auto run(A&& a, B&&b) { return a + b; } };
-struct f_sub { template<class A, class B> auto run(A&& a, B&&b) { return a - b; } };
-struct f_mul { template<class A, class B> auto run(A&& a, B&&b) { return a * b; } };
-struct f_div { template<class A, class B> auto run(A&& a, B&&b) { return a / b; } };
-struct f_mod { template<class A, class B> auto run(A&& a, B&&b) { return a % b; } };
+struct f_add { template<class A, class B> static auto run(A&& a, B&&b) { return a + b; } };
+struct f_sub { template<class A, class B> static auto run(A&& a, B&&b) { return a - b; } };
+struct f_mul { template<class A, class B> static auto run(A&& a, B&&b) { return a * b; } };
+struct f_div { template<class A, class B> static auto run(A&& a, B&&b) { return a / b; } };
+struct f_mod { template<class A, class B> static auto run(A&& a, B&&b) { return a % b; } };
 
 template<class A, class B, class=static_if<is_expr<A> && is_expr<B> > >
 ndview<f_add, A, B> operator+(const A& a, const B& b)   { return{ a, b };}
@@ -72,6 +132,573 @@ ndview<f_mod, A, B> operator%(const A& a, const B& b)   { return{ a, b };}
 
 #pragma endregion
 
+#pragma region fused
+namespace detail
+{
+#if defined(__FMA__) || defined(__AVX2__)
+inline float  fused(float  a, float  b, float  c) { return std::fma(a, b, c); }
+inline double fused(double a, double b, double c) { return std::fma(a, b, c); }
+#endif
+
+// without hardware fma, std::fma is a library call; a * b + c is left to the compiler.
+template<class A, class B, class C>
+constexpr auto fused(A a, B b, C c) { return a * b + c; }
+}
+
+struct f_fma    { template<class A, class B, class C> static auto run(A&& a, B&& b, C&& c) { return detail::fused(a, b, c);  } };
+struct f_fms    { template<class A, class B, class C> static auto run(A&& a, B&& b, C&& c) { return detail::fused(a, b, -c); } };
+struct f_fnma   { template<class A, class B, class C> static auto run(A&& a, B&& b, C&& c) { return detail::fused(-a, b, c); } };
+#pragma endregion
+
+#pragma region functions
+// element functions go through the polynomial kernels in math/approx.h,
+// see there for the error bounds.
+struct f_abs    { template<class A> static auto run(A&& a) { return approx::abs(a);     } };
+struct f_sqrt   { template<class A> static auto run(A&& a) { return approx::sqrt(a);    } };
+struct f_exp    { template<class A> static auto run(A&& a) { return approx::exp(a);     } };
+struct f_log    { template<class A> static auto run(A&& a) { return approx::log(a);     } };
+struct f_sin    { template<class A> static auto run(A&& a) { return approx::sin(a);     } };
+struct f_cos    { template<class A> static auto run(A&& a) { return approx::cos(a);     } };
+struct f_tanh   { template<class A> static auto run(A&& a) { return approx::tanh(a);    } };
+struct f_sigmoid{ template<class A> static auto run(A&& a) { return approx::sigmoid(a); } };
+
+struct f_clip
+{
+    template<class A, class L, class H>
+    static auto run(A&& a, L&& lo, H&& hi)
+    {
+        using T = std::decay_t<A>;
+        return a < T(lo) ? T(lo) : (a > T(hi) ? T(hi) : a);
+    }
+};
+
+struct f_where
+{
+    template<class C, class A, class B>
+    static auto run(C&& c, A&& a, B&& b)
+    {
+        return c ? a : b;
+    }
+};
+
+template<class A, class=static_if<is_expr<A>> > ndview<f_abs,     A> abs    (const A& a) { return{ a }; }
+template<class A, class=static_if<is_expr<A>> > ndview<f_sqrt,    A> sqrt   (const A& a) { return{ a }; }
+template<class A, class=static_if<is_expr<A>> > ndview<f_exp,     A> exp    (const A& a) { return{ a }; }
+template<class A, class=static_if<is_expr<A>> > ndview<f_log,     A> log    (const A& a) { return{ a }; }
+template<class A, class=static_if<is_expr<A>> > ndview<f_sin,     A> sin    (const A& a) { return{ a }; }
+template<class A, class=static_if<is_expr<A>> > ndview<f_cos,     A> cos    (const A& a) { return{ a }; }
+template<class A, class=static_if<is_expr<A>> > ndview<f_tanh,    A> tanh   (const A& a) { return{ a }; }
+template<class A, class=static_if<is_expr<A>> > ndview<f_sigmoid, A> sigmoid(const A& a) { return{ a }; }
+
+template<class A, class T, class=static_if<is_expr<A> && std::is_arithmetic<T>::value> >
+ndview<f_clip, A, ndscalar<T>, ndscalar<T>> clip(const A& a, T lo, T hi)
+{
+    return{ a, { lo }, { hi } };
+}
+
+template<class C, class A, class B, class=static_if<is_expr<C>> >
+auto where(const C& c, const A& a, const B& b)
+{
+    using _A = std::decay_t<decltype(to_expr(a))>;
+    using _B = std::decay_t<decltype(to_expr(b))>;
+    return ndview<f_where, C, _A, _B>{ c, to_expr(a), to_expr(b) };
+}
+
+#pragma endregion
+
+#pragma region simplify
+// same_expr(a, b): whether two expressions of one type read the same elements. leaves say
+// so when they are provably the same (same data, shape and stride); anything else is false.
+template<class E, class=void>
+struct _SameExpr
+{
+    static constexpr bool run(const E&, const E&) { return false; }
+};
+
+template<class E>
+constexpr bool same_expr(const E& a, const E& b)
+{
+    return _SameExpr<E>::run(a, b);
+}
+
+template<class T>
+struct _SameExpr<ndscalar<T>>
+{
+    static constexpr bool run(const ndscalar<T>& a, const ndscalar<T>& b) { return a.value == b.value; }
+};
+
+template<int V>
+struct _SameExpr<ndconst<V>>
+{
+    static constexpr bool run(const ndconst<V>&, const ndconst<V>&) { return true; }
+};
+
+template<class F, class A>
+struct _SameExpr<ndview<F, A>>
+{
+    static constexpr bool run(const ndview<F, A>& x, const ndview<F, A>& y) { return same_expr(x.a, y.a); }
+};
+
+template<class F, class A, class B>
+struct _SameExpr<ndview<F, A, B>>
+{
+    static constexpr bool run(const ndview<F, A, B>& x, const ndview<F, A, B>& y) { return same_expr(x.a, y.a) && same_expr(x.b, y.b); }
+};
+
+template<class F, class A, class B, class C>
+struct _SameExpr<ndview<F, A, B, C>>
+{
+    static constexpr bool run(const ndview<F, A, B, C>& x, const ndview<F, A, B, C>& y) { return same_expr(x.a, y.a) && same_expr(x.b, y.b) && same_expr(x.c, y.c); }
+};
+
+// _Rewrite<F, A, B>: the node F(a, b) built from already simplified operands.
+//   x + 0, x - 0, x * 1, x / 1 (and 0 + x, 1 * x) -> x
+//   a * b + c, a * b - c, c - a * b -> one fused multiply-add
+// _MulOf<M>: whether M is a product, and the fused node G(x, y, c) it becomes.
+template<class M>
+struct _MulOf
+{
+    static constexpr bool value = false;
+};
+
+template<class X, class Y>
+struct _MulOf<ndview<f_mul, X, Y>>
+{
+    static constexpr bool value = true;
+
+    template<class G, class C>
+    static constexpr ndview<G, X, Y, C> fuse(const ndview<f_mul, X, Y>& m, const C& c) { return{ m.a, m.b, c }; }
+};
+
+// a product on the left is fused first, so (a * b) + (c * d) keeps c * d as the addend.
+template<class F, class A, class B, class=void>
+struct _RewriteFma
+{
+    using type = ndview<F, A, B>;
+    static constexpr type run(const A& a, const B& b) { return{ a, b }; }
+};
+
+template<class M, class C>
+struct _RewriteFma<f_add, M, C, static_if<_MulOf<M>::value>>
+{
+    using type = decltype(_MulOf<M>::template fuse<f_fma>(declval<M>(), declval<C>()));
+    static constexpr type run(const M& m, const C& c) { return _MulOf<M>::template fuse<f_fma>(m, c); }
+};
+
+template<class C, class M>
+struct _RewriteFma<f_add, C, M, static_if<!_MulOf<C>::value && _MulOf<M>::value>>
+{
+    using type = decltype(_MulOf<M>::template fuse<f_fma>(declval<M>(), declval<C>()));
+    static constexpr type run(const C& c, const M& m) { return _MulOf<M>::template fuse<f_fma>(m, c); }
+};
+
+template<class M, class C>
+struct _RewriteFma<f_sub, M, C, static_if<_MulOf<M>::value>>
+{
+    using type = decltype(_MulOf<M>::template fuse<f_fms>(declval<M>(), declval<C>()));
+    static constexpr type run(const M& m, const C& c) { return _MulOf<M>::template fuse<f_fms>(m, c); }
+};
+
+template<class C, class M>
+struct _RewriteFma<f_sub, C, M, static_if<!_MulOf<C>::value && _MulOf<M>::value>>
+{
+    using type = decltype(_MulOf<M>::template fuse<f_fnma>(declval<M>(), declval<C>()));
+    static constexpr type run(const C& c, const M& m) { return _MulOf<M>::template fuse<f_fnma>(m, c); }
+};
+
+template<class F, class A, class B>
+struct _RewriteIdentity: _RewriteFma<F, A, B>
+{};
+
+template<class A, class B>
+struct _RewriteLeft
+{
+    using type = A;
+    static constexpr type run(const A& a, const B&) { return a; }
+};
+
+template<class A, class B>
+struct _RewriteRight
+{
+    using type = B;
+    static constexpr type run(const A&, const B& b) { return b; }
+};
+
+template<class A> struct _RewriteIdentity<f_add, A, ndconst<0>>: _RewriteLeft <A, ndconst<0>> {};
+template<class B> struct _RewriteIdentity<f_add, ndconst<0>, B>: _RewriteRight<ndconst<0>, B> {};
+template<class A> struct _RewriteIdentity<f_sub, A, ndconst<0>>: _RewriteLeft <A, ndconst<0>> {};
+template<class A> struct _RewriteIdentity<f_mul, A, ndconst<1>>: _RewriteLeft <A, ndconst<1>> {};
+template<class B> struct _RewriteIdentity<f_mul, ndconst<1>, B>: _RewriteRight<ndconst<1>, B> {};
+template<class A> struct _RewriteIdentity<f_div, A, ndconst<1>>: _RewriteLeft <A, ndconst<1>> {};
+
+template<class F, class A, class B>
+struct _Rewrite: _RewriteIdentity<F, A, B>
+{};
+
+// _Simplify<E>: bottom-up rewrite of an expression tree, see simplify().
+template<class E>
+struct _Simplify
+{
+    using type = E;
+    static constexpr const E& run(const E& e) { return e; }
+};
+
+template<class E>
+using simplify_t = typename _Simplify<E>::type;
+
+template<class F, class A>
+struct _Simplify<ndview<F, A>>
+{
+    using type = ndview<F, simplify_t<A>>;
+    static constexpr type run(const ndview<F, A>& e) { return{ _Simplify<A>::run(e.a) }; }
+};
+
+template<class F, class A, class B>
+struct _Simplify<ndview<F, A, B>>
+{
+    using rewrite = _Rewrite<F, simplify_t<A>, simplify_t<B>>;
+    using type    = typename rewrite::type;
+    static constexpr type run(const ndview<F, A, B>& e) { return rewrite::run(_Simplify<A>::run(e.a), _Simplify<B>::run(e.b)); }
+};
+
+template<class F, class A, class B, class C>
+struct _Simplify<ndview<F, A, B, C>>
+{
+    using type = ndview<F, simplify_t<A>, simplify_t<B>, simplify_t<C>>;
+    static constexpr type run(const ndview<F, A, B, C>& e) { return{ _Simplify<A>::run(e.a), _Simplify<B>::run(e.b), _Simplify<C>::run(e.c) }; }
+};
+
+// the expression with identities removed and multiply-adds fused. the rewrite is on types, at
+// compile time, with no runtime work, so only the constant<0> and constant<1> identities are
+// removed: a runtime scalar (ndscalar) that happens to be 0 or 1 is evaluated as it is.
+// repeated subexpressions are left to share().
+template<class E, class=static_if<is_expr<E>> >
+constexpr simplify_t<E> simplify(const E& expr)
+{
+    return _Simplify<E>::run(expr);
+}
+#pragma endregion
+
+#pragma region share
+// share(expr) evaluates each repeated subexpression of a simplified tree once per element.
+// node types that occur more than once in the tree are the candidates. constants, scalars and
+// arrays in memory are left out: reading them again costs no more than reading a shared
+// value, so x * x or x * y + x are evaluated as they are. once per call, same_expr() sorts the occurrences
+// of each candidate into distinct expressions; every distinct one is evaluated once per
+// element and its occurrences read that value, so a * b + a loads a once and
+// exp(x) * exp(x) computes exp once. the nodes under a candidate are evaluated with it and
+// are not shared any further.
+template<class E>
+struct _Shareable: true_type{};
+
+template<class T>
+struct _Shareable<ndscalar<T>>: false_type{};
+
+template<int V>
+struct _Shareable<ndconst<V>>: false_type{};
+
+template<class T, size_t N>
+struct _Shareable<ndslice<array_view<T>, N>>: false_type{};
+
+template<class T, size_t N>
+struct _Shareable<ndarray<T, N>>: false_type{};
+
+// _Count<X, E>: occurrences of the node type X in the tree E.
+template<class X, class E>
+struct _Count
+{
+    static constexpr size_t value = is_same<X, E> ? 1 : 0;
+};
+
+template<class X, class F, class ...Ts>
+struct _Count<X, ndview<F, Ts...>>
+{
+    static constexpr size_t value = (is_same<X, ndview<F, Ts...>> ? 1 : 0) + sum(size_t(0), _Count<X, Ts>::value...);
+};
+
+template<class ...Ls>
+struct _Join
+{
+    using type = types_t<>;
+};
+
+template<class ...As>
+struct _Join<types_t<As...>>
+{
+    using type = types_t<As...>;
+};
+
+template<class ...As, class ...Bs, class ...Ls>
+struct _Join<types_t<As...>, types_t<Bs...>, Ls...>: _Join<types_t<As..., Bs...>, Ls...>
+{};
+
+template<class X, class L>
+struct _CountIn;
+
+template<class X, class ...Ts>
+struct _CountIn<X, types_t<Ts...>>
+{
+    static constexpr size_t value = sum(size_t(0), size_t(is_same<X, Ts> ? 1 : 0)...);
+};
+
+// _Visible<E, Root>: the candidates of Root met walking E, without looking inside them.
+template<class E, class Root, class=void>
+struct _Visible
+{
+    using type = types_t<>;
+};
+
+template<class E, class Root>
+struct _Visible<E, Root, static_if<_Shareable<E>::value && (_Count<E, Root>::value >= 2)>>
+{
+    using type = types_t<E>;
+};
+
+template<class Root, class F, class ...Ts>
+struct _Visible<ndview<F, Ts...>, Root, static_if<!(_Count<ndview<F, Ts...>, Root>::value >= 2)>>
+{
+    using type = typename _Join<typename _Visible<Ts, Root>::type...>::type;
+};
+
+// _Groups<V>: the types met more than once in V, in order of first appearance.
+template<size_t I, class V>
+struct _GroupAt
+{
+    using X    = type_at<I, V>;
+    using type = std::conditional_t<index_of<X, V> == I && (_CountIn<X, V>::value >= 2), types_t<X>, types_t<>>;
+};
+
+template<class V, class Is = to_indexs<V::size>>
+struct _Groups;
+
+template<class V, size_t ...Is>
+struct _Groups<V, indexs_t<Is...>>
+{
+    using type = typename _Join<typename _GroupAt<Is, V>::type...>::type;
+};
+
+template<class E>
+struct _Plan
+{
+    using root    = E;
+    using visible = typename _Visible<E, E>::type;
+    using groups  = typename _Groups<visible>::type;
+
+    // group of the node type X, or groups::size.
+    template<class X>
+    static constexpr size_t group = index_of<X, groups>;
+};
+
+// the occurrences of one group: each distinct expression once, in unique[].
+template<class G, size_t K>
+struct _Group
+{
+    static constexpr size_t size = K;   // occurrences
+
+    const G*    unique[K];
+    size_t      count = 0;
+
+    // the index in unique[] of an occurrence.
+    size_t add(const G& e)
+    {
+        size_t u = 0;
+        while (u < count && !same_expr(*unique[u], e)) ++u;
+        if (u == count) unique[count++] = &e;
+        return u;
+    }
+
+    template<size_t ...Is>
+    static auto value_of(indexs_t<Is...>) -> std::decay_t<decltype(declval<const G&>()((Is, size_t(0))...))>;
+
+    // the values of unique[] at B consecutive elements along axis 0.
+    template<size_t N, size_t B>
+    struct block_t
+    {
+        decltype(value_of(to_indexs<N>{})) v[K][B];
+    };
+
+    template<class V, class ..._Is>
+    void load(V& values, size_t n, size_t i0, _Is ...is) const
+    {
+        for (size_t u = 0; u < count; ++u) {
+            const auto& e = *unique[u];
+            auto        v = values.v[u];
+            for (size_t k = 0; k < n; ++k) v[k] = e(i0 + k, is...);
+        }
+    }
+};
+
+// an occurrence of group G: reads the values of unique[index].
+template<size_t G>
+struct ndslot
+{
+    size_t index;
+};
+
+// _Share<E, Plan>: E with the occurrences of every group replaced by ndslots.
+template<class E, class Plan, class=void>
+struct _Share
+{
+    using type = E;
+
+    template<class Groups>
+    static type run(const E& e, Groups&) { return e; }
+};
+
+template<class E, class Plan>
+struct _Share<E, Plan, static_if<(Plan::template group<E> < Plan::groups::size)>>
+{
+    static constexpr size_t G = Plan::template group<E>;
+    using type = ndslot<G>;
+
+    template<class Groups>
+    static type run(const E& e, Groups& groups) { return{ std::get<G>(groups).add(e) }; }
+};
+
+template<class F, class A, class Plan>
+struct _Share<ndview<F, A>, Plan, static_if<!(_Count<ndview<F, A>, typename Plan::root>::value >= 2)>>
+{
+    using type = ndview<F, typename _Share<A, Plan>::type>;
+
+    template<class Groups>
+    static type run(const ndview<F, A>& e, Groups& groups) { return{ _Share<A, Plan>::run(e.a, groups) }; }
+};
+
+template<class F, class A, class B, class Plan>
+struct _Share<ndview<F, A, B>, Plan, static_if<!(_Count<ndview<F, A, B>, typename Plan::root>::value >= 2)>>
+{
+    using type = ndview<F, typename _Share<A, Plan>::type, typename _Share<B, Plan>::type>;
+
+    template<class Groups>
+    static type run(const ndview<F, A, B>& e, Groups& groups) { return{ _Share<A, Plan>::run(e.a, groups), _Share<B, Plan>::run(e.b, groups) }; }
+};
+
+template<class F, class A, class B, class C, class Plan>
+struct _Share<ndview<F, A, B, C>, Plan, static_if<!(_Count<ndview<F, A, B, C>, typename Plan::root>::value >= 2)>>
+{
+    using type = ndview<F, typename _Share<A, Plan>::type, typename _Share<B, Plan>::type, typename _Share<C, Plan>::type>;
+
+    template<class Groups>
+    static type run(const ndview<F, A, B, C>& e, Groups& groups) { return{ _Share<A, Plan>::run(e.a, groups), _Share<B, Plan>::run(e.b, groups), _Share<C, Plan>::run(e.c, groups) }; }
+};
+
+// _Eval<E>: element k of a block of a shared tree, at position is..., given the block values
+// of the groups.
+template<class E>
+struct _Eval
+{
+    template<class V, class ..._Is>
+    static constexpr auto run(const E& e, const V&, size_t, _Is ...is) { return e(is...); }
+};
+
+template<size_t G>
+struct _Eval<ndslot<G>>
+{
+    template<class V, class ..._Is>
+    static constexpr auto run(const ndslot<G>& e, const V& values, size_t k, _Is ...) { return std::get<G>(values).v[e.index][k]; }
+};
+
+template<class F, class A>
+struct _Eval<ndview<F, A>>
+{
+    template<class V, class ..._Is>
+    static constexpr auto run(const ndview<F, A>& e, const V& values, size_t k, _Is ...is) { return F::run(_Eval<A>::run(e.a, values, k, is...)); }
+};
+
+template<class F, class A, class B>
+struct _Eval<ndview<F, A, B>>
+{
+    template<class V, class ..._Is>
+    static constexpr auto run(const ndview<F, A, B>& e, const V& values, size_t k, _Is ...is) { return F::run(_Eval<A>::run(e.a, values, k, is...), _Eval<B>::run(e.b, values, k, is...)); }
+};
+
+template<class F, class A, class B, class C>
+struct _Eval<ndview<F, A, B, C>>
+{
+    template<class V, class ..._Is>
+    static constexpr auto run(const ndview<F, A, B, C>& e, const V& values, size_t k, _Is ...is) { return F::run(_Eval<A>::run(e.a, values, k, is...), _Eval<B>::run(e.b, values, k, is...), _Eval<C>::run(e.c, values, k, is...)); }
+};
+
+// the plan share() returns. it is evaluated a block at a time: load() computes every distinct
+// expression of the groups at up to `block` consecutive elements along axis 0, then at()
+// gives each element of the tree, reading those values.
+template<class Tree, class ...Gs>
+struct ndlet
+{
+    static constexpr size_t block = 64;
+
+    template<size_t N>
+    using values_t = std::tuple<typename Gs::template block_t<N, block>...>;
+
+    std::tuple<Gs...>   groups;
+    Tree                tree;
+
+    // whether any group has fewer distinct expressions than occurrences.
+    bool shared() const
+    {
+        return shared(to_indexs<sizeof...(Gs)>{});
+    }
+
+    // elements (i0 + k, is...) for k in [0, n), n <= block.
+    template<class V, class ..._Is>
+    void load(V& values, size_t n, size_t i0, _Is ...is) const
+    {
+        load(to_indexs<sizeof...(Gs)>{}, values, n, i0, is...);
+    }
+
+    // element k of the loaded block, at (is...).
+    template<class V, class ..._Is>
+    auto at(const V& values, size_t k, _Is ...is) const
+    {
+        return _Eval<Tree>::run(tree, values, k, is...);
+    }
+
+private:
+    template<size_t ...Gi>
+    bool shared(indexs_t<Gi...>) const
+    {
+        return !if_all((std::get<Gi>(groups).count == Gs::size)...);
+    }
+
+    template<size_t ...Gi, class V, class ..._Is>
+    void load(indexs_t<Gi...>, V& values, size_t n, size_t i0, _Is ...is) const
+    {
+        const int loads[] = { (std::get<Gi>(groups).load(std::get<Gi>(values), n, i0, is...), 0)... };
+        (void)loads;
+    }
+};
+
+template<class E, class Groups = typename _Plan<E>::groups>
+struct _Let;
+
+template<class E, class ...Gs>
+struct _Let<E, types_t<Gs...>>
+{
+    using plan   = _Plan<E>;
+    using groups = std::tuple<_Group<Gs, _CountIn<Gs, typename plan::visible>::value>...>;
+    using type   = ndlet<typename _Share<E, plan>::type, _Group<Gs, _CountIn<Gs, typename plan::visible>::value>...>;
+
+    static type run(const E& expr)
+    {
+        groups found;
+        auto   tree = _Share<E, plan>::run(expr, found);
+        return{ found, tree };
+    }
+};
+
+// whether some subexpression type, other than a leaf in memory, repeats in the simplified tree
+// E, so share() has something to do.
+template<class E>
+constexpr bool can_share = _Plan<E>::groups::size != 0;
+
+// the plan keeps pointers into `expr`, which must outlive it.
+template<class E, class=static_if<can_share<E>> >
+typename _Let<E>::type share(const E& expr)
+{
+    return _Let<E>::run(expr);
+}
+#pragma endregion
+
 #pragma endregion
 
 }
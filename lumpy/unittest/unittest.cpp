@@ -39,6 +39,11 @@ struct MethodInfo
             printf(ok_str);
             printf(fmt_str, name);
 
+        } catch(const std::exception& e) {
+            printf(fail_str);
+            printf(fmt_str, name);
+            printf("%s\n", e.what());
+            return false;
         } catch(...) {
             printf(fail_str);
             printf(fmt_str, name);
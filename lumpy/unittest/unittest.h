@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdexcept>
+
 #include <lumpy/core.h>
 
 namespace lumpy
@@ -69,6 +71,10 @@ lumpy_abi int lumpy_unittest_invoke(const char* type = nullptr, const char* name
 #define unittest(name)                                                      \
 struct __declspec(dllexport) name : lumpy::unittest::IUnitTest<name>
 
+// fails the running testcase (it throws) when its expression is false.
+#define testassert(...)                                                                \
+do { if (!(__VA_ARGS__)) throw std::logic_error(std::string(__FILE__) + "(" + std::to_string(__LINE__) + "): " #__VA_ARGS__); } while (0)
+
 #define testcase(name)                                                                  \
 static const char* name##_test(void* obj) { _invoke(obj, &name); return __FUNCTION__;}  \
 int  _install_##name = _install(&name##_test, __FILE__, __LINE__);                      \
@@ -0,0 +1,67 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/unittest.h>
+#include <lumpy/core.h>
+
+
+namespace lumpy
+{
+namespace core
+{
+
+unittest(parallel_test)
+{
+
+    testcase(cover)
+    {
+        const size_t count = 100003;
+        std::vector<int> hits(count);
+        parallel_for(count, 1000, [&](size_t, size_t first, size_t last) {
+            for (auto i = first; i < last; ++i) hits[i] += 1;
+        });
+        for (auto hit : hits) testassert(hit == 1);
+
+        auto calls = 0;
+        parallel_for(0, 1, [&](size_t, size_t, size_t) { ++calls; });
+        testassert(calls == 0);
+    }
+
+    testcase(nested)
+    {
+        std::atomic<size_t> sum{ 0 };
+        parallel_for(64, 1, [&](size_t, size_t first, size_t last) {
+            for (auto i = first; i < last; ++i) {
+                parallel_for(1000, 10, [&](size_t, size_t a, size_t b) { sum += b - a; });
+            }
+        });
+        testassert(sum == 64 * 1000);
+    }
+
+    testcase(exception)
+    {
+        // thrown on whichever thread runs the last chunk, rethrown to the caller.
+        for (auto repeat = 0; repeat < 100; ++repeat) {
+            auto thrown = false;
+            try {
+                parallel_for(1000, 1, [&](size_t, size_t, size_t last) {
+                    if (last == 1000) throw std::runtime_error("task");
+                });
+            }
+            catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            testassert(thrown);
+        }
+
+        // the pool is still usable afterwards.
+        std::atomic<size_t> count{ 0 };
+        parallel_for(1000, 1, [&](size_t, size_t first, size_t last) { count += last - first; });
+        testassert(count == 1000);
+    }
+
+};
+
+}
+}
@@ -0,0 +1,121 @@
+// the counters only exist in profile builds; the unittest project defines LUMPY_PROFILE for
+// every file, so all of them see the same kernels.
+#include <atomic>
+#include <sstream>
+
+#include <lumpy/unittest.h>
+#include <lumpy/core.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace core
+{
+
+unittest(trace_test)
+{
+
+#if LUMPY_PROFILE
+    const trace::event* find(const char* name)
+    {
+        for (auto& buffer : trace::detail::get_registry().buffers) {
+            for (auto& e : buffer->events) {
+                if (string(e.name) == name) return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    testcase(events)
+    {
+        trace::clear();
+        trace::enable();
+        {
+            lumpy_trace("trace.outer", trace::path::simd, 100, 800);
+            lumpy_trace_alloc(64);
+        }
+        trace::enable(false);
+        {
+            lumpy_trace("trace.disabled", trace::path::scalar, 1, 1);
+        }
+
+        auto e = find("trace.outer");
+        testassert(e != nullptr);
+        testassert(e->how == trace::path::simd && e->elements == 100 && e->bytes == 800);
+        testassert(e->allocs == 1 && e->alloc_bytes == 64);
+        testassert(e->end >= e->begin);
+        testassert(find("trace.disabled") == nullptr);
+
+        std::ostringstream json;
+        trace::write_trace(json);
+        testassert(json.str().find("\"name\":\"trace.outer\"") != string::npos);
+    }
+
+    testcase(parallel_allocs)
+    {
+        // allocations made by tasks on the pool's threads count toward the caller's scope.
+        trace::clear();
+        trace::enable();
+
+        std::atomic<size_t> tasks{ 0 };
+        {
+            lumpy_trace("trace.parallel", trace::path::parallel, 1 << 20, 0);
+            parallel_for(1 << 20, 1 << 10, [&](size_t, size_t, size_t) {
+                lumpy_trace_alloc(16);
+                ++tasks;
+            });
+        }
+        trace::enable(false);
+
+        auto e = find("trace.parallel");
+        testassert(e != nullptr);
+        testassert(e->allocs == tasks && e->alloc_bytes == 16 * tasks);
+    }
+
+    testcase(kernels)
+    {
+        const size_t n = 1 << 20;
+        auto a = math::random::uniform<double>({ n }, 1);
+        math::ndarray<double, 1> b({ n });
+
+        trace::clear();
+        trace::enable();
+        math::sort(a);
+        math::assign(b, a * a + a);
+        trace::enable(false);
+
+        // both are split into more than one task whenever there is more than one thread.
+        const auto how = thread_count() > 1 ? trace::path::parallel : trace::path::scalar;
+
+        auto s = find("sort");
+        testassert(s != nullptr);
+        testassert(s->how == how && s->elements == n && s->bytes == 2 * n * sizeof(double));
+        testassert(s->end >= s->begin);
+
+        auto e = find("assign");
+        testassert(e != nullptr);
+        testassert(e->how == how && e->elements == n && e->bytes == n * sizeof(double));
+        testassert(find("random.fill") == nullptr);
+
+        // a small factorization runs on the calling thread, a large one is split.
+        auto small = math::random::normal<double>({ 16, 16 }, 2);
+        auto large = math::random::normal<double>({ 512, 512 }, 3);
+        trace::clear();
+        trace::enable();
+        math::lu(small);
+        trace::enable(false);
+        testassert(find("linalg.lu") != nullptr && find("linalg.lu")->how == trace::path::scalar);
+
+        trace::clear();
+        trace::enable();
+        math::lu(large);
+        trace::enable(false);
+        testassert(find("linalg.lu") != nullptr && find("linalg.lu")->how == how);
+    }
+#endif
+
+};
+
+}
+}
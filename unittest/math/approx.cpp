@@ -0,0 +1,82 @@
+#include <cmath>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+// error of `value` in ulps of the float result `exact`.
+static double ulps(float value, double exact)
+{
+    int e;
+    std::frexp(exact, &e);
+    return std::fabs(value - exact) / std::ldexp(1.0, std::max(e - 24, -149));
+}
+
+unittest(approx_test)
+{
+
+    testcase(bounds)
+    {
+        double exp_err = 0, log_err = 0, sin_err = 0, tanh_err = 0, sigmoid_err = 0;
+        for (int i = -20000; i <= 20000; ++i) {
+            auto x = float(i) * 0.0043f;
+            exp_err     = std::max(exp_err,     ulps(approx::exp(x), std::exp(double(x))));
+            sin_err     = std::max(sin_err,     ulps(approx::sin(x), std::sin(double(x))));
+            tanh_err    = std::max(tanh_err,    ulps(approx::tanh(x), std::tanh(double(x))));
+            sigmoid_err = std::max(sigmoid_err, ulps(approx::sigmoid(x), 1.0 / (1.0 + std::exp(-double(x)))));
+
+            auto y = std::exp(float(i) * 0.004f);
+            log_err     = std::max(log_err,     ulps(approx::log(y), std::log(double(y))));
+        }
+        testassert(exp_err     <= 1.0);
+        testassert(log_err     <= 1.0);
+        testassert(sin_err     <= 2.0);
+        testassert(tanh_err    <= 1.5);
+        testassert(sigmoid_err <= 1.5);
+    }
+
+    testcase(sigmoid_tail)
+    {
+        // denormal results, not 0.
+        testassert(approx::sigmoid(-95.0f) > 0.0f);
+        testassert(ulps(approx::sigmoid(-95.0f), 1.0 / (1.0 + std::exp(95.0))) <= 1.5);
+        testassert(approx::sigmoid(-720.0) > 0.0);
+        testassert(std::fabs(approx::sigmoid(-720.0) / std::exp(-720.0) - 1.0) < 1e-6);
+
+        testassert(approx::sigmoid(200.0f) == 1.0f);
+        testassert(approx::sigmoid(-200.0f) == 0.0f);
+        testassert(approx::sigmoid(0.0)   == 0.5);
+    }
+
+    testcase(special)
+    {
+        testassert(approx::log(0.0f) == -std::numeric_limits<float>::infinity());
+        testassert(approx::log(std::numeric_limits<double>::infinity()) == std::numeric_limits<double>::infinity());
+        testassert(std::isnan(approx::log(-1.0f)));
+        testassert(approx::exp(-1000.0) == 0.0);
+        testassert(approx::exp(1000.0f) == std::numeric_limits<float>::infinity());
+        testassert(approx::abs(-3) == 3);
+    }
+
+    testcase(expression)
+    {
+        ndarray<float, 2> a({ 3, 2 });
+        for (size_t i = 0; i < a.size(); ++i) a.data()[i] = float(i) - 2.5f;
+
+        auto r = eval<float>({ 3, 2 }, sigmoid(a) + tanh(a));
+        for (size_t j = 0; j < 2; ++j) {
+            for (size_t i = 0; i < 3; ++i) {
+                testassert(r(i, j) == approx::sigmoid(a(i, j)) + approx::tanh(a(i, j)));
+            }
+        }
+    }
+
+};
+
+}
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(batch_test)
+{
+
+    // matrix q of the batch `a`.
+    static ndarray<double, 2> matrix(const ndarray<double, 3>& a, size_t q)
+    {
+        const auto m = a.shape()[1], n = a.shape()[2];
+        ndarray<double, 2> r({ m, n });
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t i = 0; i < m; ++i) r.data()[i + j * m] = a(q, i, j);
+        }
+        return r;
+    }
+
+    testcase(results)
+    {
+        // the unrolled sizes, and some that take the runtime-size path.
+        for (size_t n : { 1, 2, 3, 4, 5, 8, 9, 33 }) {
+            const size_t batch = 70;
+            auto a = random::normal<double>({ batch, n, n }, 1);
+            auto b = random::normal<double>({ batch, n, n }, 2);
+            auto v = random::normal<double>({ batch, n }, 3);
+
+            auto c = batch_matmul(a, b);
+            auto i = batch_inv(a);
+            auto d = batch_det(a);
+            auto x = batch_solve(a, v);
+            auto y = batch_solve(a, b);
+
+            for (size_t q = 0; q < batch; ++q) {
+                const auto A = matrix(a, q);
+                testassert(std::fabs(d(q) - det(A)) <= 1e-9 * std::max(1.0, std::fabs(det(A))));
+
+                for (size_t r = 0; r < n; ++r) {
+                    double sv = 0;
+                    for (size_t p = 0; p < n; ++p) sv += a(q, r, p) * x(q, p);
+                    testassert(std::fabs(sv - v(q, r)) < 1e-8);
+
+                    for (size_t s = 0; s < n; ++s) {
+                        double sc = 0, si = 0, sy = 0;
+                        for (size_t p = 0; p < n; ++p) {
+                            sc += a(q, r, p) * b(q, p, s);
+                            si += a(q, r, p) * i(q, p, s);
+                            sy += a(q, r, p) * y(q, p, s);
+                        }
+                        testassert(std::fabs(sc - c(q, r, s)) < 1e-12);
+                        testassert(std::fabs(si - (r == s ? 1.0 : 0.0)) < 1e-8);
+                        testassert(std::fabs(sy - b(q, r, s)) < 1e-8);
+                    }
+                }
+            }
+        }
+    }
+
+    testcase(rectangular)
+    {
+        auto a = random::normal<double>({ 40, 3, 5 }, 1);
+        auto b = random::normal<double>({ 40, 5, 2 }, 2);
+        auto c = batch_matmul(a, b);
+
+        for (size_t q = 0; q < 40; ++q) {
+            for (size_t i = 0; i < 3; ++i) {
+                for (size_t j = 0; j < 2; ++j) {
+                    double s = 0;
+                    for (size_t p = 0; p < 5; ++p) s += a(q, i, p) * b(q, p, j);
+                    testassert(std::fabs(s - c(q, i, j)) < 1e-12);
+                }
+            }
+        }
+    }
+
+    testcase(empty)
+    {
+        // no matrices.
+        ndarray<double, 3> none({ 0, 3, 3 });
+        testassert(batch_matmul(none, none).size() == 0);
+        testassert(batch_inv(none).size() == 0);
+        testassert(batch_det(none).size() == 0);
+        testassert(batch_solve(none, ndarray<double, 2>({ 0, 3 })).size() == 0);
+
+        // 0 x 0 matrices: empty inverses and solutions, determinants of 1.
+        ndarray<double, 3> zero({ 4, 0, 0 });
+        testassert(batch_matmul(zero, zero).size() == 0);
+        testassert(batch_inv(zero).size() == 0);
+        testassert(batch_solve(zero, ndarray<double, 3>({ 4, 0, 2 })).size() == 0);
+        auto d = batch_det(zero);
+        testassert(d.shape()[0] == 4);
+        for (size_t q = 0; q < 4; ++q) testassert(d(q) == 1.0);
+
+        // an empty inner dimension gives zeros.
+        auto c = batch_matmul(ndarray<double, 3>({ 4, 2, 0 }), ndarray<double, 3>({ 4, 0, 3 }));
+        testassert(c.shape()[0] == 4 && c.shape()[1] == 2 && c.shape()[2] == 3);
+        for (size_t i = 0; i < c.size(); ++i) testassert(c.data()[i] == 0.0);
+
+        // no right hand sides.
+        auto a = random::normal<double>({ 4, 3, 3 }, 1);
+        testassert(batch_solve(a, ndarray<double, 3>({ 4, 3, 0 })).size() == 0);
+    }
+
+    testcase(errors)
+    {
+        size_t thrown = 0;
+        try { batch_inv(ndarray<double, 3>({ 2, 3, 4 })); }                                      catch (const std::invalid_argument&) { ++thrown; }
+        try { batch_matmul(ndarray<double, 3>({ 2, 3, 4 }), ndarray<double, 3>({ 2, 3, 4 })); }  catch (const std::invalid_argument&) { ++thrown; }
+        try { batch_solve(ndarray<double, 3>({ 2, 3, 3 }), ndarray<double, 2>({ 3, 3 })); }      catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 3);
+    }
+
+    testcase(singular)
+    {
+        // one matrix with a zero column among regular ones, for an unrolled size and a runtime one.
+        for (size_t n : { 3, 5 }) {
+            auto a = random::normal<double>({ 70, n, n }, 1);
+            for (size_t i = 0; i < n; ++i) a.data()[lane_offset(a, 0, i + n) + 40] = 0;
+            auto b = random::normal<double>({ 70, n }, 2);
+
+            auto thrown = 0;
+            try { batch_inv(a); }       catch (const std::domain_error&) { ++thrown; }
+            try { batch_solve(a, b); }  catch (const std::domain_error&) { ++thrown; }
+            testassert(thrown == 2);
+
+            auto d = batch_det(a);
+            testassert(d(40) == 0.0);
+            testassert(d(39) != 0.0 && d(41) != 0.0);
+        }
+    }
+
+};
+
+}
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(concat_test)
+{
+
+    using slice_t = ndslice<array_view<double>, 2>;
+
+    // max |a - b|.
+    template<class A, class B>
+    static double distance(const A& a, const B& b)
+    {
+        double e = 0;
+        for (size_t j = 0; j < a.shape()[1]; ++j) {
+            for (size_t i = 0; i < a.shape()[0]; ++i) e = std::max(e, std::fabs(a(i, j) - b(i, j)));
+        }
+        return e;
+    }
+
+    testcase(joined)
+    {
+        auto a = random::normal<double>({ 4, 3 }, 1);
+        auto b = random::normal<double>({ 4, 5 }, 2);
+        auto c = random::normal<double>({ 2, 3 }, 3);
+
+        auto ab = concatenate({ a, b }, 1);
+        testassert(ab.shape()[0] == 4 && ab.shape()[1] == 8);
+        for (size_t i = 0; i < 4; ++i) {
+            for (size_t j = 0; j < 3; ++j) testassert(ab(i, j) == a(i, j));
+            for (size_t j = 0; j < 5; ++j) testassert(ab(i, j + 3) == b(i, j));
+        }
+
+        auto ac = concatenate({ a, c }, 0);
+        testassert(ac.shape()[0] == 6 && ac.shape()[1] == 3);
+        for (size_t j = 0; j < 3; ++j) {
+            for (size_t i = 0; i < 4; ++i) testassert(ac(i, j) == a(i, j));
+            for (size_t i = 0; i < 2; ++i) testassert(ac(i + 4, j) == c(i, j));
+        }
+
+        auto s = stack({ a, a }, 2);
+        testassert(s.shape()[0] == 4 && s.shape()[1] == 3 && s.shape()[2] == 2);
+        for (size_t j = 0; j < 3; ++j) {
+            for (size_t i = 0; i < 4; ++i) testassert(s(i, j, 0) == a(i, j) && s(i, j, 1) == a(i, j));
+        }
+    }
+
+    testcase(slices)
+    {
+        auto x = random::normal<double>({ 5, 12 }, 4);
+        const slice_t& all = x;
+
+        // slices are inclusive: columns 0..3 and 4..11.
+        auto c = concatenate({ all.slice({ 0, $ }, { 0, 3 }), all.slice({ 0, $ }, { 4, $ }) }, 1);
+        testassert(distance(c, x) == 0);
+        testassert(&c.data()[0] != &x.data()[0]);
+
+        auto s = stack(std::vector<slice_t>{ all.slice({ 0, $ }, { 0, 5 }), all.slice({ 0, $ }, { 6, $ }) }, 0);
+        testassert(s.shape()[0] == 2 && s.shape()[1] == 5 && s.shape()[2] == 6);
+        for (size_t j = 0; j < 6; ++j) {
+            for (size_t i = 0; i < 5; ++i) testassert(s(0, i, j) == x(i, j) && s(1, i, j) == x(i, j + 6));
+        }
+
+        // a contiguous slice, or an array that only views its elements, is still copied.
+        auto v = ascontiguous(all);
+        testassert(&v.data()[0] != &x.data()[0] && distance(v, x) == 0);
+        auto w = ascontiguous(ndarray<double, 2>(all, nullptr));
+        testassert(&w.data()[0] != &x.data()[0] && distance(w, x) == 0);
+        testassert(&ascontiguous(x).data()[0] == &x.data()[0]);
+    }
+
+    testcase(single)
+    {
+        // one part still gives a new array, which the caller may write to.
+        auto a = random::normal<double>({ 4, 3 }, 5);
+        const auto first = a(0, 0);
+
+        auto c = concatenate({ a });
+        auto s = stack({ a }, 0);
+        testassert(&c.data()[0] != &a.data()[0] && &s.data()[0] != &a.data()[0]);
+
+        c.data()[0] = first + 1;
+        s.data()[0] = first + 2;
+        testassert(a(0, 0) == first);
+        testassert(c(1, 2) == a(1, 2) && s(0, 1, 2) == a(1, 2));
+
+        auto v = concatenate(std::vector<ndarray<double, 2>>{ a }, 1);
+        auto w = stack(std::vector<ndarray<double, 2>>{ a }, 2);
+        v.data()[0] = first + 3;
+        w.data()[0] = first + 4;
+        testassert(a(0, 0) == first);
+    }
+
+    testcase(chunked)
+    {
+        std::vector<ndarray<double, 2>> parts;
+        size_t total = 0;
+        for (size_t k = 0; k < 7; ++k) {
+            parts.push_back(random::normal<double>({ 5, 3 + k * 5 }, k));
+            total += 3 + k * 5;
+        }
+        auto c = chunked_concatenate(parts, 1);
+        auto full = concatenate(parts, 1);
+        auto x = random::normal<double>({ 5, total }, 9);
+
+        // evaluated part by part.
+        auto r = eval<double>({ 5, total }, c + x * c);
+        for (size_t j = 0; j < total; ++j) {
+            for (size_t i = 0; i < 5; ++i) testassert(r(i, j) == full(i, j) + x(i, j) * full(i, j));
+        }
+
+        // the same axis with other boundaries.
+        const slice_t& all = full;
+        auto d = chunked_concatenate(std::vector<slice_t>{ all.slice({ 0, $ }, { 0, 9 }), all.slice({ 0, $ }, { 10, $ }) }, 1);
+        auto e = eval<double>({ 5, total }, c - d);
+        for (size_t i = 0; i < e.size(); ++i) testassert(e.data()[i] == 0.0);
+
+        // another axis: element by element.
+        auto rows = chunked_concatenate(std::vector<ndarray<double, 2>>{ full.slice({ 0, 1 }, { 0, $ }), full.slice({ 2, 4 }, { 0, $ }) }, 0);
+        auto m = eval<double>({ 5, total }, c - rows);
+        for (size_t i = 0; i < m.size(); ++i) testassert(m.data()[i] == 0.0);
+
+        testassert(distance(ascontiguous(c), full) == 0);
+    }
+
+    testcase(errors)
+    {
+        ndarray<double, 1> a({ 4 });
+        ndarray<double, 2> b({ 4, 3 }), c({ 5, 3 });
+
+        auto bb = chunked_concatenate(std::vector<ndarray<double, 2>>{ b, b }, 1);
+
+        size_t thrown = 0;
+        try { concatenate({ a, a }, 3); }                                       catch (const std::invalid_argument&) { ++thrown; }
+        try { stack({ a, a }, 2); }                                             catch (const std::invalid_argument&) { ++thrown; }
+        try { chunked_concatenate(std::vector<ndarray<double, 1>>{ a }, 1); }  catch (const std::invalid_argument&) { ++thrown; }
+        try { concatenate({ b, c }, 1); }                                       catch (const std::invalid_argument&) { ++thrown; }
+        try { eval<double>({ 4, 7 }, bb + b); }                                 catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 5);
+    }
+
+};
+
+}
+}
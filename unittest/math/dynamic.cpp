@@ -0,0 +1,87 @@
+#include <stdexcept>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(dynamic_test)
+{
+
+    testcase(dtype)
+    {
+        static_assert(dtype_of<float>() == dtype::f32, "");
+        static_assert(dtype_of<long long>() == dtype::i64, "");
+        static_assert(dtype_size(dtype::i16) == 2 && dtype_float(dtype::f64) && !dtype_float(dtype::i32), "");
+
+        testassert(to_dtype("f8")  == dtype::f64);
+        testassert(to_dtype("|u1") == dtype::u8);
+        testassert(to_dtype("=i4") == dtype::i32);
+        testassert(to_dtype(">i1") == dtype::i8);       // no byte order for one byte
+
+        const auto native  = string(1, detail::native_order);
+        const auto swapped = string(1, detail::native_order == '<' ? '>' : '<');
+        testassert(to_dtype(native + "f4") == dtype::f32);
+
+        auto thrown = 0;
+        try { to_dtype(swapped + "f8"); } catch (const std::invalid_argument&) { ++thrown; }
+        try { to_dtype(swapped + "u2"); } catch (const std::invalid_argument&) { ++thrown; }
+        try { to_dtype("<c8"); }          catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 3);
+    }
+
+    testcase(visit)
+    {
+        auto a = random::uniform<float>({ 6, 5 }, 1);
+        dyn_array d(a);
+        testassert(d.type() == dtype::f32 && d.rank() == 2);
+
+        math::visit(d, [](auto s) { sort(s, 0); });
+        for (size_t j = 0; j < 5; ++j) {
+            for (size_t i = 1; i < 6; ++i) testassert(a(i, j) >= a(i - 1, j));
+        }
+
+        dyn_array e(dtype::i32, { 100, 3 });
+        math::visit(e, [](auto s) { random::fill(s, 3, random::f_integers<llong>{ 0, 7 }); });
+        auto h = math::visit(e, [](auto s) { return dyn_array(histogram(s, 7, 0.0, 7.0)); });
+        testassert(h.type() == dtype_of<size_t>());
+
+        auto bins  = h.as<size_t, 1>();
+        size_t total = 0;
+        for (size_t i = 0; i < 7; ++i) total += bins(i);
+        testassert(total == 300);
+    }
+
+    testcase(access)
+    {
+        auto a = random::uniform<float>({ 6, 5 }, 1);
+        auto s = dyn_array(a.slice({ 1, 3 }, { 0, $ }));
+        testassert(s.as<float, 2>()(size_t(0), size_t(1)) == a(size_t(1), size_t(1)));
+
+        auto thrown = 0;
+        try { s.as<double, 2>(); }                      catch (const std::invalid_argument&) { ++thrown; }
+        try { s.as<float, 3>(); }                       catch (const std::invalid_argument&) { ++thrown; }
+        try { dyn_array(dtype::f32, {}); }              catch (const std::invalid_argument&) { ++thrown; }
+        try { dyn_array(dtype::f32, { 1, 1, 1, 1, 1 }); } catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 4);
+    }
+
+    testcase(empty)
+    {
+        dyn_array e(dtype::f64, { 4, 0, 3 });
+        testassert(e.size() == 0);
+
+        auto v = e.as<double, 3>();
+        testassert(v.size() == 0 && v.shape()[0] == 4 && v.shape()[1] == 0 && v.shape()[2] == 3);
+        testassert(v.data().size() == 0);
+        testassert(e.as_array<double, 3>().size() == 0);
+    }
+
+};
+
+}
+}
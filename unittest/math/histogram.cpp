@@ -0,0 +1,98 @@
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(histogram_test)
+{
+
+    testcase(bincount)
+    {
+        auto k = random::integers<int>({ 700, 500 }, 1, 0, 50);
+        std::vector<size_t> ref(50);
+        for (size_t j = 0; j < 500; ++j) {
+            for (size_t i = 0; i < 700; ++i) ref[k(i, j)] += 1;
+        }
+
+        auto bins = math::bincount(k);
+        testassert(bins.shape()[0] == 50);
+        for (size_t i = 0; i < 50; ++i) testassert(bins(i) == ref[i]);
+
+        testassert(math::bincount(k, 60).shape()[0] == 60);
+
+        // no values: minlength bins, none by default.
+        ndarray<int, 1> none({ 0 });
+        testassert(math::bincount(none).shape()[0] == 0);
+        testassert(math::bincount(none, 5).shape()[0] == 5);
+    }
+
+    testcase(equal_bins)
+    {
+        auto u = random::uniform<double>({ 1000, 500 }, 3, -0.5, 1.5);
+        std::vector<size_t> ref(10);
+        for (size_t j = 0; j < 500; ++j) {
+            for (size_t i = 0; i < 1000; ++i) {
+                auto v = u(i, j);
+                if (v >= 0.0 && v <= 1.0) ref[std::min(size_t(v * 10), size_t(9))] += 1;
+            }
+        }
+
+        auto h = histogram(u, 10, 0.0, 1.0);
+        testassert(h.shape()[0] == 10);
+        for (size_t i = 0; i < 10; ++i) testassert(h(i) == ref[i]);
+
+        double bounds[] = { 0.0, 0.1, 0.5, 1.0 };
+        auto e = histogram(u, reshape(bounds, { 4 }));
+        testassert(e.shape()[0] == 3);
+        testassert(e(size_t(0)) == ref[0]);
+    }
+
+    testcase(degenerate)
+    {
+        auto u = random::uniform<double>({ 100 }, 3);
+        auto thrown = 0;
+        try { histogram(u, 0, 0.0, 1.0); }  catch (const std::invalid_argument&) { ++thrown; }
+        try { histogram(u, 4, 1.0, 1.0); }  catch (const std::invalid_argument&) { ++thrown; }
+
+        double one[] = { 0.5 };
+        double down[] = { 0.0, 0.5, 0.2, 1.0 };
+        try { histogram(u, reshape(one, { 1 })); }     catch (const std::invalid_argument&) { ++thrown; }
+        try { histogram(u, reshape(down, { 4 })); }    catch (const std::invalid_argument&) { ++thrown; }
+
+        auto k = random::integers<int>({ 100 }, 1, -2, 5);
+        try { math::bincount(k); }                      catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 5);
+    }
+
+    testcase(unique)
+    {
+        // below and above the size where unique() switches from sorting to hashing.
+        for (size_t n : { 200, 6000 }) {
+            auto k = random::integers<int>({ 300, n }, 1, -5, 2000);
+            std::map<int, size_t> ref;
+            for (size_t j = 0; j < n; ++j) {
+                for (size_t i = 0; i < 300; ++i) ref[k(i, j)] += 1;
+            }
+
+            auto result = math::unique(k);
+            testassert(result.first.shape()[0] == ref.size());
+            size_t t = 0;
+            for (auto& item : ref) {
+                testassert(result.first(t) == item.first && result.second(t) == item.second);
+                ++t;
+            }
+        }
+    }
+
+};
+
+}
+}
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(linalg_test)
+{
+
+    // max |a * x - b|.
+    template<class A, class X, class B>
+    static double residual(const A& a, const X& x, const B& b)
+    {
+        const auto n = a.shape()[0], m = a.shape()[1], k = x.shape()[1];
+        double e = 0;
+        for (size_t j = 0; j < k; ++j) {
+            for (size_t i = 0; i < n; ++i) {
+                double s = 0;
+                for (size_t p = 0; p < m; ++p) s += double(a(i, p)) * double(x(p, j));
+                e = std::max(e, std::fabs(s - double(b(i, j))));
+            }
+        }
+        return e;
+    }
+
+    static ndarray<double, 2> transpose(const ndarray<double, 2>& a)
+    {
+        ndarray<double, 2> t({ a.shape()[1], a.shape()[0] });
+        for (size_t j = 0; j < a.shape()[1]; ++j) {
+            for (size_t i = 0; i < a.shape()[0]; ++i) t.data()[j + i * a.shape()[1]] = a(i, j);
+        }
+        return t;
+    }
+
+    static ndarray<double, 2> identity(size_t n)
+    {
+        ndarray<double, 2> e({ n, n });
+        for (size_t i = 0; i < n * n; ++i) e.data()[i] = i % (n + 1) == 0 ? 1.0 : 0.0;
+        return e;
+    }
+
+    testcase(factorizations)
+    {
+        // sizes around the 64-column panel.
+        for (size_t n : { 1, 5, 63, 64, 65, 150 }) {
+            auto a = random::normal<double>({ n, n }, 1);
+            auto b = random::normal<double>({ n, 3 }, 2);
+
+            testassert(residual(a, solve(a, b), b) < 1e-9);
+            testassert(residual(a, inv(a), identity(n)) < 1e-9);
+
+            // a * a^T + n is positive definite.
+            ndarray<double, 2> s({ n, n });
+            for (size_t j = 0; j < n; ++j) {
+                for (size_t i = 0; i < n; ++i) {
+                    double v = i == j ? double(n) : 0.0;
+                    for (size_t p = 0; p < n; ++p) v += a(i, p) * a(j, p);
+                    s.data()[i + j * n] = v;
+                }
+            }
+            auto l = cholesky(s);
+            testassert(residual(l, transpose(l), s) < 1e-8 * n);
+
+            auto qr = math::qr(a);
+            testassert(residual(qr.first, qr.second, a) < 1e-10 * n);
+            testassert(residual(transpose(qr.first), qr.first, identity(n)) < 1e-12 * n);
+        }
+    }
+
+    testcase(shapes)
+    {
+        auto t = random::normal<double>({ 120, 70 }, 3);
+        auto tall = math::qr(t);
+        testassert(tall.first.shape()[1] == 70 && tall.second.shape()[0] == 70);
+        testassert(residual(tall.first, tall.second, t) < 1e-10);
+
+        auto w = random::normal<double>({ 70, 120 }, 3);
+        auto wide = math::qr(w);
+        testassert(wide.first.shape()[1] == 70 && wide.second.shape()[1] == 120);
+        testassert(residual(wide.first, wide.second, w) < 1e-10);
+
+        auto a = random::normal<double>({ 40, 40 }, 1);
+        auto v = random::normal<double>({ 40 }, 5);
+        auto x = solve(a, v);
+        for (size_t i = 0; i < 40; ++i) {
+            double s = 0;
+            for (size_t p = 0; p < 40; ++p) s += a(i, p) * x(p);
+            testassert(std::fabs(s - v(i)) < 1e-9);
+        }
+    }
+
+    testcase(determinant)
+    {
+        double upper[] = { 2, 0, 0, 1, 3, 0, 4, 5, 6 };
+        testassert(std::fabs(det(reshape(upper, { 3, 3 })) - 36.0) < 1e-12);
+
+        double swap[] = { 0, 1, 0, 1, 0, 0, 0, 0, 1 };
+        testassert(det(reshape(swap, { 3, 3 })) == -1.0);
+    }
+
+    testcase(triangular)
+    {
+        auto t = random::normal<double>({ 10, 10 }, 4);
+        for (size_t i = 0; i < 10; ++i) t.data()[i + i * 10] += 5;
+        auto b = random::normal<double>({ 10 }, 5);
+
+        for (auto lower : { true, false }) {
+            auto x = solve_triangular(t, b, lower);
+            for (size_t i = 0; i < 10; ++i) {
+                double s = 0;
+                for (size_t p = 0; p < 10; ++p) {
+                    if (lower ? p <= i : p >= i) s += t(i, p) * x(p);
+                }
+                testassert(std::fabs(s - b(i)) < 1e-10);
+            }
+        }
+    }
+
+    testcase(errors)
+    {
+        ndarray<double, 2> ones({ 2, 2 });
+        std::fill(&ones.data()[0], &ones.data()[0] + 4, 1.0);
+        auto b = random::normal<double>({ 2 }, 1);
+        auto c = random::normal<double>({ 3 }, 1);
+        auto r = random::normal<double>({ 2, 3 }, 1);
+
+        auto thrown = 0;
+        try { solve(ones, b); }     catch (const std::domain_error&)     { ++thrown; }
+        try { solve(ones, c); }     catch (const std::invalid_argument&) { ++thrown; }
+        try { inv(r); }             catch (const std::invalid_argument&) { ++thrown; }
+        try { cholesky(r); }        catch (const std::invalid_argument&) { ++thrown; }
+
+        double indefinite[] = { 1, 2, 2, 1 };
+        try { cholesky(reshape(indefinite, { 2, 2 })); } catch (const std::domain_error&) { ++thrown; }
+        testassert(thrown == 5);
+    }
+
+    testcase(empty)
+    {
+        ndarray<double, 2> a({ 0, 0 });
+        testassert(det(a) == 1.0);
+        testassert(inv(a).size() == 0);
+        testassert(math::qr(a).first.size() == 0);
+        testassert(solve(a, ndarray<double, 1>({ 0 })).size() == 0);
+    }
+
+};
+
+}
+}
@@ -0,0 +1,109 @@
+#include <cmath>
+#include <stdexcept>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(random_test)
+{
+
+    testcase(known_answers)
+    {
+        // philox4x32-10 vectors from the random123 distribution (kat_vectors).
+        auto a = random::philox(random::bits_t{ { 0, 0, 0, 0 } }, array<uint, 2>{ { 0, 0 } });
+        testassert(a[0] == 0x6627e8d5u && a[1] == 0xe169c58du && a[2] == 0xbc57ac4cu && a[3] == 0x9b00dbd8u);
+
+        auto b = random::philox(random::bits_t{ { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu } }, array<uint, 2>{ { 0xffffffffu, 0xffffffffu } });
+        testassert(b[0] == 0x408f276du && b[1] == 0x41c83b0eu && b[2] == 0xa20bc7c6u && b[3] == 0x6d5451fdu);
+
+        auto c = random::philox(random::bits_t{ { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u } }, array<uint, 2>{ { 0xa4093822u, 0x299f31d0u } });
+        testassert(c[0] == 0xd16cfe09u && c[1] == 0x94fdccebu && c[2] == 0x5001e420u && c[3] == 0x24126ea1u);
+
+        // the 64-bit counter and seed are the low words.
+        auto d = random::philox(0x85a308d3243f6a88ull, 0x299f31d0a4093822ull);
+        auto e = random::philox(random::bits_t{ { 0x243f6a88u, 0x85a308d3u, 0, 0 } }, array<uint, 2>{ { 0xa4093822u, 0x299f31d0u } });
+        for (size_t i = 0; i < 4; ++i) testassert(d[i] == e[i]);
+    }
+
+    testcase(reproducible)
+    {
+        auto a = random::uniform<float>({ 300, 200 }, 42);
+        auto b = random::uniform<float>({ 300, 200 }, 42);
+        auto c = random::uniform<float>({ 300, 200 }, 43);
+        auto v = random::view({ 300, 200 }, 42, random::f_uniform<float>{});
+
+        size_t differ = 0;
+        for (size_t j = 0; j < 200; ++j) {
+            for (size_t i = 0; i < 300; ++i) {
+                testassert(a(i, j) == b(i, j));
+                testassert(a(i, j) == v(i, j));
+                testassert(a(i, j) >= 0.0f && a(i, j) < 1.0f);
+                differ += a(i, j) != c(i, j);
+            }
+        }
+        testassert(differ > 59000);
+    }
+
+    testcase(sliced_fill)
+    {
+        // element (i, j) of a slice gets the value of logical position (i, j), whatever its strides.
+        ndarray<float, 2> a({ 10, 10 });
+        auto s = a.slice({ 2, 5 }, { 1, 3 });
+        random::fill(s, 9, random::f_uniform<float>{});
+
+        auto v = random::view({ 4, 3 }, 9, random::f_uniform<float>{});
+        for (size_t i = 0; i < 4; ++i) {
+            for (size_t j = 0; j < 3; ++j) testassert(s(i, j) == v(i, j));
+        }
+    }
+
+    testcase(moments)
+    {
+        const size_t n = 1000000;
+        auto x = random::normal<double>({ n }, 7, 1.0, 2.0);
+        double sum = 0, sum2 = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum  += x(i);
+            sum2 += x(i) * x(i);
+        }
+        const auto mean = sum / n;
+        testassert(std::fabs(mean - 1.0) < 0.01);
+        testassert(std::fabs(sum2 / n - mean * mean - 4.0) < 0.04);
+
+        auto k = random::integers<int>({ 100000 }, 1, -3, 4);
+        auto lo = 100, hi = -100;
+        for (size_t i = 0; i < 100000; ++i) {
+            lo = std::min(lo, k(i));
+            hi = std::max(hi, k(i));
+        }
+        testassert(lo == -3 && hi == 3);
+
+        auto b = random::bernoulli({ 100000 }, 1, 0.25);
+        size_t ones = 0;
+        for (size_t i = 0; i < 100000; ++i) ones += b(i);
+        testassert(ones > 24000 && ones < 26000);
+    }
+
+    testcase(errors)
+    {
+        auto thrown = 0;
+        try { random::integers<int>({ 10 }, 1, 4, 4); }     catch (const std::invalid_argument&) { ++thrown; }
+        try { random::integers<int>({ 10 }, 1, 4, -3); }    catch (const std::invalid_argument&) { ++thrown; }
+        try { random::bernoulli({ 10 }, 1, -0.1); }         catch (const std::invalid_argument&) { ++thrown; }
+        try { random::bernoulli({ 10 }, 1, 1.5); }          catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 4);
+
+        testassert(random::bernoulli({ 10 }, 1, 1.0)(9));
+        testassert(!random::bernoulli({ 10 }, 1, 0.0)(9));
+    }
+
+};
+
+}
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(rolling_test)
+{
+
+    testcase(sliding_window)
+    {
+        ndarray<int, 2> m({ 5, 3 });
+        for (size_t i = 0; i < m.size(); ++i) m.data()[i] = int(i);
+
+        auto w = math::sliding_window(ndslice<array_view<int>, 2>(m), 3, 0);
+        testassert(w.shape()[0] == 3 && w.shape()[1] == 3 && w.shape()[2] == 3);
+        testassert(w(1, 2, 2) == m(3, 2));
+
+        auto v = math::sliding_window(ndslice<array_view<int>, 2>(m), 2, 1);
+        testassert(v(4, 1, 1) == m(4, 2));
+    }
+
+    testcase(statistics)
+    {
+        // long enough to be cut into several chunks per lane.
+        const size_t n = 100000, window = 1000, count = n - window + 1;
+        auto x = random::normal<double>({ n }, 7);
+        auto k = random::integers<int>({ n }, 7, -1000, 1000);
+
+        auto sum  = rolling_sum(x, window);
+        auto mean = rolling_mean(x, window);
+        auto var  = rolling_var(x, window, 0, 1);
+        auto high = rolling_max(x, window);
+        auto low  = rolling_min(k, window);
+        auto isum = rolling_sum(k, window);
+        testassert(sum.shape()[0] == count);
+
+        for (size_t j = 0; j < count; j += 997) {
+            double s = 0, h = x(j);
+            llong  t = 0;
+            auto   l = k(j);
+            for (size_t i = j; i < j + window; ++i) {
+                s += x(i);
+                t += k(i);
+                h  = std::max(h, x(i));
+                l  = std::min(l, k(i));
+            }
+            double m = s / window, v = 0;
+            for (size_t i = j; i < j + window; ++i) v += (x(i) - m) * (x(i) - m);
+
+            testassert(std::fabs(sum(j) - s) < 1e-9);
+            testassert(std::fabs(mean(j) - m) < 1e-12);
+            testassert(std::fabs(var(j) - v / (window - 1)) < 1e-9);
+            testassert(high(j) == h && low(j) == l && isum(j) == t);
+        }
+    }
+
+    testcase(axis)
+    {
+        auto y = random::uniform<float>({ 4, 500 }, 3);
+        auto r = rolling_max(y, 10, 1);
+        testassert(r.shape()[0] == 4 && r.shape()[1] == 491);
+        for (size_t i = 0; i < 4; ++i) {
+            for (size_t j = 0; j < 491; ++j) {
+                auto h = y(i, j);
+                for (size_t t = 1; t < 10; ++t) h = std::max(h, y(i, j + t));
+                testassert(r(i, j) == h);
+            }
+        }
+
+        auto whole = rolling_sum(y, 500, 1);
+        testassert(whole.shape()[1] == 1);
+    }
+
+    testcase(arguments)
+    {
+        auto x = random::uniform<double>({ 10 }, 1);
+        auto thrown = 0;
+        try { rolling_min(x, 0); }                              catch (const std::invalid_argument&) { ++thrown; }
+        try { rolling_sum(x, 11); }                             catch (const std::invalid_argument&) { ++thrown; }
+        try { rolling_mean(x, 3, 1); }                          catch (const std::invalid_argument&) { ++thrown; }
+        try { rolling_var(x, 3, 0, 3); }                        catch (const std::invalid_argument&) { ++thrown; }
+        try { math::sliding_window(ndslice<array_view<double>, 1>(x), 0); }  catch (const std::invalid_argument&) { ++thrown; }
+        try { math::sliding_window(ndslice<array_view<double>, 1>(x), 11); } catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 6);
+    }
+
+};
+
+}
+}
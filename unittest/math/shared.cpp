@@ -0,0 +1,110 @@
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(shared_test)
+{
+
+#if defined(__unix__) || defined(__APPLE__)
+    testcase(share)
+    {
+        auto writer = shared_array::create<double, 2>("lumpy_unittest", { 100, 3 });
+        auto a = writer.as<double, 2>();
+        for (size_t i = 0; i < a.size(); ++i) a.data()[i] = double(i);
+
+        // a second mapping of the same segment, as another process would get it.
+        auto reader = shared_array::open("lumpy_unittest");
+        testassert(reader.type() == dtype::f64 && reader.rank() == 2);
+        testassert(reader.shape()[0] == 100 && reader.shape()[1] == 3);
+
+        // a read-only mapping only gives out const views.
+        testassert(!reader.writable());
+        auto b = reader.as<const double, 2>();
+        testassert(b(99, 2) == 299.0);
+
+        const auto version = reader.version();
+        testassert(reader.unchanged(version));
+        writer.begin_write();
+        testassert(!reader.unchanged(reader.version()));
+        a.data()[0] = 42.0;
+        writer.publish();
+        testassert(!reader.unchanged(version));
+        testassert(reader.unchanged(reader.version()));
+        testassert(b(0, 0) == 42.0);
+
+        auto errors = 0;
+        try { reader.as<const float, 2>(); }   catch (const std::invalid_argument&) { ++errors; }
+        try { reader.as<double, 2>(); }        catch (const std::invalid_argument&) { ++errors; }
+        try { reader.array(); }                catch (const std::invalid_argument&) { ++errors; }
+        testassert(errors == 3);
+
+        auto other = shared_array::open("lumpy_unittest", true);
+        testassert(other.writable());
+        other.as<double, 2>().data()[1] = 7.0;
+        testassert(b(1, 0) == 7.0 && other.array().size() == 300);
+
+        // the name goes, existing mappings stay.
+        shared_array::remove("lumpy_unittest");
+        auto thrown = false;
+        try { shared_array::open("lumpy_unittest"); } catch (const std::system_error&) { thrown = true; }
+        testassert(thrown);
+        testassert(b(0, 0) == 42.0);
+    }
+
+    testcase(bad_header)
+    {
+        const size_t size = detail::shared_offset + 64;
+        auto corrupt = [&](void (*edit)(detail::shared_header&)) {
+            auto seg = shared_array::create<float, 1>("lumpy_unittest_bad", { 16 });
+            auto fd  = ::shm_open("/lumpy_unittest_bad", O_RDWR, 0);
+            auto map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            edit(*static_cast<detail::shared_header*>(map));
+            ::munmap(map, size);
+
+            auto thrown = false;
+            try { shared_array::open("lumpy_unittest_bad"); } catch (const std::invalid_argument&) { thrown = true; }
+            shared_array::remove("lumpy_unittest_bad");
+            return thrown;
+        };
+
+        testassert(corrupt([](detail::shared_header& h) { h.magic = 0; }));
+        testassert(corrupt([](detail::shared_header& h) { h.rank  = 9; }));
+        testassert(corrupt([](detail::shared_header& h) { h.type  = 200; }));
+        testassert(corrupt([](detail::shared_header& h) { h.shape[0] = 17; }));
+        testassert(corrupt([](detail::shared_header& h) { h.bytes = 1 << 20; }));
+        testassert(corrupt([](detail::shared_header& h) { h.offset = 8; }));
+        testassert(corrupt([](detail::shared_header& h) { h.offset += 2; h.shape[0] = 14; h.bytes = 56; }));
+        testassert(!corrupt([](detail::shared_header&) {}));
+    }
+
+    testcase(too_large)
+    {
+        const auto huge = std::numeric_limits<size_t>::max() / 4;
+        auto thrown = 0;
+        const auto wide = size_t(1) << 40;
+        try { shared_array::create<double, 2>("lumpy_unittest_big", { huge, 1 }); }       catch (const std::invalid_argument&) { ++thrown; }
+        try { shared_array::create<double, 2>("lumpy_unittest_big", { wide, wide }); }    catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 2);
+    }
+#endif
+
+};
+
+}
+}
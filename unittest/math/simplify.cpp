@@ -0,0 +1,131 @@
+#include <cmath>
+#include <type_traits>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+// a 1-d leaf that counts its loads.
+struct counted
+{
+    const double*   data;
+    size_t*         loads;
+
+    double operator()(size_t i) const
+    {
+        ++*loads;
+        return data[i];
+    }
+};
+
+template<>
+struct _IsExpr<counted>: true_type{};
+
+template<>
+struct _SameExpr<counted>
+{
+    static bool run(const counted& a, const counted& b) { return a.data == b.data; }
+};
+
+unittest(simplify_test)
+{
+
+    testcase(rewrite)
+    {
+        using A = ndarray<double, 2>;
+        A a({ 2, 2 }), b({ 2, 2 });
+
+        testassert(std::is_same<decltype(simplify(a + constant<0>)), A>::value);
+        testassert(std::is_same<decltype(simplify(constant<1> * (a - constant<0>))), A>::value);
+        testassert(std::is_same<decltype(simplify(a * b - a)), ndview<f_fms, A, A, A>>::value);
+        testassert(std::is_same<decltype(simplify(a - a * b)), ndview<f_fnma, A, A, A>>::value);
+
+        // the multiply-add is fused before anything is shared.
+        testassert(std::is_same<decltype(simplify(a * b + b * a)), ndview<f_fma, A, A, ndview<f_mul, A, A>>>::value);
+    }
+
+    testcase(loads)
+    {
+        double x[8], y[8], z[8];
+        for (size_t i = 0; i < 8; ++i) {
+            x[i] = double(i) + 1;
+            y[i] = double(i) * 10;
+            z[i] = double(i) - 4;
+        }
+
+        size_t loads_a = 0, loads_b = 0;
+        counted a{ x, &loads_a }, b{ y, &loads_b };
+
+        // a repeated leaf, at different depths.
+        auto r = eval<double>({ 8 }, a * b + a);
+        testassert(loads_a == 8 && loads_b == 8);
+        for (size_t i = 0; i < 8; ++i) testassert(r(i) == x[i] * y[i] + x[i]);
+
+        // a repeated subtree: exp(a) is computed once, so a is loaded once.
+        loads_a = loads_b = 0;
+        auto e = eval<double>({ 8 }, exp(a) * exp(a) + b);
+        testassert(loads_a == 8 && loads_b == 8);
+        for (size_t i = 0; i < 8; ++i) testassert(e(i) == approx::exp(x[i]) * approx::exp(x[i]) + y[i]);
+
+        // occurrences of one type that are not the same expression are all loaded.
+        size_t loads_c = 0;
+        counted c{ z, &loads_c };
+        loads_a = loads_b = 0;
+        auto s = eval<double>({ 8 }, a * b + c * a);
+        testassert(loads_a == 8 && loads_b == 8 && loads_c == 8);
+        for (size_t i = 0; i < 8; ++i) testassert(s(i) == x[i] * y[i] + z[i] * x[i]);
+
+        loads_a = loads_b = 0;
+        eval<double>({ 8 }, a + b);
+        testassert(loads_a == 8 && loads_b == 8);
+    }
+
+    testcase(arrays)
+    {
+        ndarray<double, 2> x({ 30, 20 }), y({ 30, 20 });
+        for (size_t i = 0; i < x.size(); ++i) {
+            x.data()[i] = double(i) * 0.5;
+            y.data()[i] = double(i % 7);
+        }
+
+        // repeats of arrays alone are not worth a plan: these take the unshared path.
+        using A = ndarray<double, 2>;
+        testassert(!can_share<simplify_t<decltype(x * x)>>);
+        testassert(!can_share<simplify_t<decltype(x * y + x)>>);
+        testassert(!can_share<simplify_t<decltype(x * y + x + y * y - x * x)>>);
+        testassert(!can_share<ndview<f_mul, ndslice<array_view<double>, 2>, ndslice<array_view<double>, 2>>>);
+        testassert(!can_share<ndview<f_mul, ndscalar<double>, ndview<f_add, A, ndscalar<double>>>>);
+        testassert(can_share<simplify_t<decltype(exp(x) * exp(x))>>);
+
+        // exp(x) is shared and y is not: the plan keeps y as an array operand.
+        auto q = eval<double>({ 30, 20 }, exp(x) * exp(x) + y);
+        for (size_t j = 0; j < 20; ++j) {
+            for (size_t i = 0; i < 30; ++i) testassert(q(i, j) == approx::exp(x(i, j)) * approx::exp(x(i, j)) + y(i, j));
+        }
+
+        auto r = eval<double>({ 30, 20 }, x * y + x + y * y - x * x);
+        for (size_t j = 0; j < 20; ++j) {
+            for (size_t i = 0; i < 30; ++i) {
+                const auto u = x(i, j), v = y(i, j);
+                testassert(std::fabs(r(i, j) - (u * v + u + v * v - u * u)) <= 1e-12 * (1 + u * u));
+            }
+        }
+
+        // views of one array at different offsets are different expressions.
+        auto a = x.slice({ 0, 14 }, { 0, $ });
+        auto b = x.slice({ 15, 29 }, { 0, $ });
+        auto d = eval<double>({ 15, 20 }, exp(a) - exp(b));
+        for (size_t j = 0; j < 20; ++j) {
+            for (size_t i = 0; i < 15; ++i) testassert(d(i, j) == approx::exp(x(i, j)) - approx::exp(x(i + 15, j)));
+        }
+    }
+
+};
+
+}
+}
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <lumpy/unittest.h>
+#include <lumpy/math.h>
+
+
+namespace lumpy
+{
+namespace math
+{
+
+unittest(sort_test)
+{
+
+    ndarray<float, 2> random(size_t rows, size_t cols)
+    {
+        std::mt19937 gen(3);
+        ndarray<float, 2> a({ rows, cols });
+        for (size_t i = 0; i < a.size(); ++i) a.data()[i] = float(gen() % 100);
+        return a;
+    }
+
+    ndarray<float, 2> copy(const ndarray<float, 2>& a)
+    {
+        ndarray<float, 2> b({ a.shape()[0], a.shape()[1] });
+        for (size_t i = 0; i < a.size(); ++i) b.data()[i] = a.data()[i];
+        return b;
+    }
+
+    testcase(sort_axes)
+    {
+        auto a = random(5, 7);
+        for (size_t axis = 0; axis < 2; ++axis) {
+            auto c = copy(a);
+            auto index = argsort(c, axis);
+            sort(c, axis);
+
+            for (size_t i = 0; i < 5; ++i) {
+                for (size_t j = 0; j < 7; ++j) {
+                    if (axis == 0 && i > 0) testassert(c(i, j) >= c(i - 1, j));
+                    if (axis == 1 && j > 0) testassert(c(i, j) >= c(i, j - 1));
+
+                    auto k = index(i, j);
+                    testassert((axis == 0 ? a(k, j) : a(i, k)) == c(i, j));
+                }
+            }
+        }
+    }
+
+    testcase(large_1d)
+    {
+        std::mt19937 gen(5);
+        const size_t n = 300000;
+        ndarray<double, 1> a({ n });
+        for (size_t i = 0; i < n; ++i) a.data()[i] = double(gen());
+
+        std::vector<double> ref(&a.data()[0], &a.data()[0] + n);
+        std::sort(ref.begin(), ref.end());
+
+        auto best = topk(a, 10);
+        for (size_t i = 0; i < 10; ++i) {
+            testassert(best.first(i) == ref[n - 1 - i]);
+            testassert(a(best.second(i)) == ref[n - 1 - i]);
+        }
+
+        sort(a);
+        testassert(std::equal(ref.begin(), ref.end(), &a.data()[0]));
+    }
+
+    testcase(topk_partition)
+    {
+        auto a = random(5, 7);
+        auto c = copy(a);
+        sort(c, 1);
+
+        auto best = topk(a, 3, 1);
+        testassert(best.first.shape()[1] == 3);
+        for (size_t i = 0; i < 5; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                testassert(best.first(i, j) == c(i, 6 - j));
+                testassert(a(i, best.second(i, j)) == best.first(i, j));
+            }
+        }
+
+        auto d = copy(a);
+        partition(d, 2, 1);
+        for (size_t i = 0; i < 5; ++i) testassert(d(i, size_t(2)) == c(i, size_t(2)));
+
+        auto e = copy(a);
+        partition(e, $, 1);
+        for (size_t i = 0; i < 5; ++i) testassert(e(i, size_t(6)) == c(i, size_t(6)));
+    }
+
+    testcase(empty)
+    {
+        ndarray<float, 2> a({ 0, 3 });
+        testassert(argsort(a).size() == 0);
+        sort(a);
+        sort(a, 1);
+        testassert(topk(a, 2).first.size() == 0);
+
+        auto b = random(4, 3);
+        auto none = topk(b, 0);
+        testassert(none.first.size() == 0 && none.second.shape()[1] == 3);
+    }
+
+    testcase(partition_range)
+    {
+        auto a = random(4, 3);
+        auto thrown = false;
+        try { partition(a, 4); } catch (const std::invalid_argument&) { thrown = true; }
+        testassert(thrown);
+
+        ndarray<float, 2> b({ 0, 3 });
+        thrown = false;
+        try { partition(b, 0); } catch (const std::invalid_argument&) { thrown = true; }
+        testassert(thrown);
+    }
+
+    testcase(axis_range)
+    {
+        auto a = random(4, 3);
+        auto thrown = 0;
+        try { sort(a, 2); }             catch (const std::invalid_argument&) { ++thrown; }
+        try { argsort(a, 2); }          catch (const std::invalid_argument&) { ++thrown; }
+        try { partition(a, 0, 2); }     catch (const std::invalid_argument&) { ++thrown; }
+        try { topk(a, 1, 2); }          catch (const std::invalid_argument&) { ++thrown; }
+        testassert(thrown == 4);
+    }
+
+};
+
+}
+}